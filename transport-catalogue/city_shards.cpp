@@ -0,0 +1,125 @@
+#include "city_shards.h"
+
+#include "request_handler.h"
+
+#include <chrono>
+#include <ctime>
+#include <future>
+
+namespace transport_catalogue {
+
+namespace {
+
+int64_t GetThreadCpuTimeNs() {
+    timespec time{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+    return static_cast<int64_t>(time.tv_sec) * 1'000'000'000 + time.tv_nsec;
+}
+
+double NsToMs(int64_t ns) {
+    return static_cast<double>(ns) / 1'000'000.0;
+}
+
+} // namespace
+
+CityShards::CityShards(const json::Node& cities, ThreadPool& pool) 
+    : pool_(pool) {
+    std::vector<std::future<void>> builds;
+    for (const auto& [city, city_requests] : cities.AsMap()) {
+        auto shard = std::make_unique<Shard>();
+        shard->city = city;
+        builds.push_back(pool_.Submit([&shard = *shard, &city_requests = city_requests] {
+            BuildShard(shard, city_requests);
+        }));
+        shards_.emplace(city, std::move(shard));
+    }
+    // Задачи ссылаются на шарды, поэтому до выброса исключения нужно дождаться их всех
+    for (auto& build : builds) {
+        build.wait();
+    }
+    for (auto& build : builds) {
+        build.get();
+    }
+}
+
+std::vector<json_processing::Stat> CityShards::ProcessRequests(
+        const std::vector<json_processing::StatRequest>& requests) {
+    using namespace std::literals;
+    std::vector<json_processing::Stat> result;
+    result.reserve(requests.size());
+    std::vector<std::future<std::optional<json_processing::Stat>>> pending;
+    auto collect_pending = [&result, &pending] {
+        // Задачи ссылаются на requests, поэтому до выброса исключения нужно дождаться их всех
+        for (auto& stat : pending) {
+            stat.wait();
+        }
+        for (auto& stat : pending) {
+            if (auto value = stat.get()) {
+                result.push_back(std::move(*value));
+            }
+        }
+        pending.clear();
+    };
+    for (const auto& request : requests) {
+        // Статистика шардов учитывает все предшествующие запросы пакета, поэтому дожидается их
+        if (request.type == "ShardStats"s) {
+            collect_pending();
+            result.push_back(json_processing::Stat{request.id, GetUsage()});
+            continue;
+        }
+        pending.push_back(pool_.Submit([this, &request] {
+            return ProcessRequest(request);
+        }));
+    }
+    collect_pending();
+    return result;
+}
+
+std::vector<ShardUsage> CityShards::GetUsage() const {
+    std::vector<ShardUsage> result;
+    for (const auto& [city, shard] : shards_) {
+        auto snapshot = shard->versions->Acquire();
+        result.push_back(ShardUsage{city, 
+            snapshot->catalogue.EstimateMemoryUsage() + snapshot->router.EstimateMemoryUsage(),
+            NsToMs(shard->build_cpu_ns.load()), NsToMs(shard->query_cpu_ns.load()), shard->requests.load()});
+    }
+    return result;
+}
+
+void CityShards::BuildShard(Shard& shard, const json::Node& city_requests) {
+    const int64_t start = GetThreadCpuTimeNs();
+    json_processing::JsonReader reader;
+    reader.ParseDocument(city_requests);
+    TransportCatalogue catalogue;
+    reader.FillBase(catalogue);
+    shard.versions = std::make_unique<VersionedCatalogue>(std::move(catalogue), 
+        reader.GetRoutingSettings(), reader.GetRenderSettings());
+    shard.build_cpu_ns += GetThreadCpuTimeNs() - start;
+}
+
+std::optional<json_processing::Stat> CityShards::ProcessRequest(const json_processing::StatRequest& request) {
+    using namespace std::literals;
+    auto it = shards_.find(request.city);
+    if (it == shards_.end()) {
+        return json_processing::Stat{request.id, json_processing::StatError{"unknown city"s}};
+    }
+    Shard& shard = *it->second;
+    const int64_t start = GetThreadCpuTimeNs();
+    auto snapshot = shard.versions->Acquire();
+    RequestHandler handler{snapshot->catalogue, snapshot->renderer, snapshot->router};
+    json_processing::StatProcessor processor(handler);
+    std::optional<json_processing::Stat> result = processor.Process(request);
+    shard.query_cpu_ns += GetThreadCpuTimeNs() - start;
+    ++shard.requests;
+    return result;
+}
+
+void ServeCities(const json::Node& cities, const std::vector<json_processing::StatRequest>& stat_requests,
+        std::ostream& output) {
+    ThreadPool pool;
+    CityShards shards(cities, pool);
+    json_processing::JsonPrinter printer(shards.ProcessRequests(stat_requests));
+    printer.PrintStats(output);
+}
+
+} // namespace transport_catalogue
\ No newline at end of file
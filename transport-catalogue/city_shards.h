@@ -0,0 +1,53 @@
+#pragma once
+
+#include "json.h"
+#include "json_reader.h"
+#include "thread_pool.h"
+#include "versioned_catalogue.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace transport_catalogue {
+
+// Несколько независимых справочников в одном процессе, по одному на город.
+// Шарды строятся параллельно, а запросы к ним выполняются общим пулом потоков
+class CityShards {
+public:
+    // cities — словарь вида {"город": {"base_requests": ..., "render_settings": ..., "routing_settings": ...}}
+    CityShards(const json::Node& cities, ThreadPool& pool);
+
+    // Запросы выполняются параллельно. Запрос ShardStats дожидается всех запросов перед ним
+    std::vector<json_processing::Stat> ProcessRequests(const std::vector<json_processing::StatRequest>& requests);
+
+    std::vector<ShardUsage> GetUsage() const;
+
+private:
+    struct Shard {
+        std::string city;
+        std::unique_ptr<VersionedCatalogue> versions;
+        std::atomic<int64_t> build_cpu_ns{0};
+        std::atomic<int64_t> query_cpu_ns{0};
+        std::atomic<size_t> requests{0};
+    };
+
+    ThreadPool& pool_;
+    std::map<std::string, std::unique_ptr<Shard>, std::less<>> shards_;
+
+    static void BuildShard(Shard& shard, const json::Node& city_requests);
+
+    std::optional<json_processing::Stat> ProcessRequest(const json_processing::StatRequest& request);
+};
+
+// Строит справочники городов из раздела "cities" и отвечает на запросы к ним
+void ServeCities(const json::Node& cities, const std::vector<json_processing::StatRequest>& stat_requests,
+    std::ostream& output);
+
+} // namespace transport_catalogue
\ No newline at end of file
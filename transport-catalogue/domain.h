@@ -2,6 +2,8 @@
 
 #include "geo.h"
 
+#include <cstdint>
+#include <set>
 #include <string>
 #include <string_view>
 #include <unordered_map>
@@ -13,6 +15,8 @@ namespace transport_catalogue {
 struct Stop {
     std::string stopname;
     geo::Coordinates coordinates;
+    // Порядковый номер остановки в справочнике, назначается при добавлении
+    size_t id = 0;
 };
 
 struct Bus {
@@ -35,6 +39,33 @@ struct BusInfo {
     double curvature;
 };
 
+struct StopDistance {
+    const Stop* stop = nullptr;
+    double distance = 0.0;
+};
+
+struct AreaInfo {
+    std::vector<std::string> stops;
+    std::set<std::string> buses;
+};
+
+// Координаты остановок по их номерам. Широты и долготы хранятся в отдельных массивах,
+// чтобы их можно было обходить плотным циклом
+struct StopCoordinates {
+    std::vector<double> lats;
+    std::vector<double> lngs;
+    // Ненулевое значение отмечает остановки, через которые проходит хотя бы один маршрут
+    std::vector<uint8_t> in_routes;
+};
+
+struct ShardUsage {
+    std::string city;
+    size_t memory_bytes = 0;
+    double build_cpu_ms = 0.0;
+    double query_cpu_ms = 0.0;
+    size_t requests = 0;
+};
+
 struct StopDistHasher {
 	size_t operator()(const std::pair<const Stop*, const Stop*>& stops) const {
 		return std::hash<const void*>{}(stops.first) + 11 * std::hash<const void*>{}(stops.second);
@@ -13,6 +13,15 @@ struct Coordinates {
     }
 };
 
+struct Area {
+    Coordinates min;
+    Coordinates max;
+    bool Contains(Coordinates point) const {
+        return point.lat >= min.lat && point.lat <= max.lat
+            && point.lng >= min.lng && point.lng <= max.lng;
+    }
+};
+
 double ComputeDistance(Coordinates from, Coordinates to);
 
 }  // namespace geo
\ No newline at end of file
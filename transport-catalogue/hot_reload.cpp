@@ -0,0 +1,113 @@
+#include "hot_reload.h"
+
+#include "json_reader.h"
+#include "query_server.h"
+#include "stream_reader.h"
+
+#include <fstream>
+#include <system_error>
+
+namespace transport_catalogue {
+
+namespace {
+
+std::filesystem::file_time_type GetWriteTime(const std::filesystem::path& path) {
+    std::error_code error;
+    auto time = std::filesystem::last_write_time(path, error);
+    return error ? std::filesystem::file_time_type::min() : time;
+}
+
+json_processing::JsonReader ReadBase(const std::filesystem::path& path, TransportCatalogue& catalogue) {
+    using namespace std::literals;
+    std::ifstream input(path);
+    if (!input) {
+        throw std::runtime_error("Failed to open "s + path.string());
+    }
+    json_processing::JsonReader reader;
+    reader.ParseDocument(json::Node(json_processing::StreamingReader(catalogue).Read(input)));
+    return reader;
+}
+
+} // namespace
+
+BaseFileWatcher::BaseFileWatcher(std::filesystem::path path, VersionedCatalogue& versions,
+        std::chrono::milliseconds poll_interval)
+    : path_(std::move(path)), versions_(versions), poll_interval_(poll_interval),
+    last_write_time_(GetWriteTime(path_)), pending_write_time_(last_write_time_),
+    thread_([this] { Run(); }) {
+}
+
+BaseFileWatcher::~BaseFileWatcher() {
+    {
+        std::lock_guard guard(mutex_);
+        stop_requested_ = true;
+    }
+    stop_cv_.notify_all();
+    thread_.join();
+}
+
+void BaseFileWatcher::Run() {
+    std::unique_lock lock(mutex_);
+    while (!stop_cv_.wait_for(lock, poll_interval_, [this] { return stop_requested_; })) {
+        const auto write_time = GetWriteTime(path_);
+        if (write_time == last_write_time_) {
+            continue;
+        }
+        // Ждём, пока файл перестанет меняться, чтобы не читать его посреди записи
+        if (write_time != pending_write_time_) {
+            pending_write_time_ = write_time;
+            continue;
+        }
+        last_write_time_ = write_time;
+        lock.unlock();
+        Reload();
+        lock.lock();
+    }
+}
+
+void BaseFileWatcher::Reload() {
+    try {
+        TransportCatalogue catalogue;
+        auto reader = ReadBase(path_, catalogue);
+        versions_.Replace(std::move(catalogue), reader.GetRoutingSettings(), reader.GetRenderSettings());
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to reload " << path_.string() << ": " << e.what() << std::endl;
+    }
+}
+
+std::unique_ptr<VersionedCatalogue> LoadVersionedCatalogue(const std::filesystem::path& path) {
+    TransportCatalogue catalogue;
+    auto reader = ReadBase(path, catalogue);
+    return std::make_unique<VersionedCatalogue>(std::move(catalogue),
+        reader.GetRoutingSettings(), reader.GetRenderSettings());
+}
+
+int ServeWithHotReload(const std::filesystem::path& base_path, std::istream& input, std::ostream& output) {
+    auto versions = LoadVersionedCatalogue(base_path);
+    BaseFileWatcher watcher(base_path, *versions);
+    QueryServer(*versions).Serve(input, output);
+    return 0;
+}
+
+int CheckMapReuse(const std::filesystem::path& base_path, const std::filesystem::path& updated_path,
+        std::ostream& output) {
+    auto versions = LoadVersionedCatalogue(base_path);
+    {
+        auto previous = versions->Acquire();
+        previous->renderer.GetMap(previous->catalogue);
+    }
+    TransportCatalogue catalogue;
+    auto reader = ReadBase(updated_path, catalogue);
+    versions->Replace(std::move(catalogue), reader.GetRoutingSettings(), reader.GetRenderSettings());
+    auto current = versions->Acquire();
+    const auto reused = current->renderer.GetMap(current->catalogue);
+    renderer::MapRenderer fresh(reader.GetRenderSettings(), current->catalogue.GetStopCoordinates());
+    if (*fresh.GetMap(current->catalogue) != *reused) {
+        output << "Map rendered from reused fragments differs from a full render" << std::endl;
+        return 1;
+    }
+    output << "Map rendered from reused fragments matches a full render" << std::endl;
+    return 0;
+}
+
+} // namespace transport_catalogue
\ No newline at end of file
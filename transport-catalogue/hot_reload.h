@@ -0,0 +1,57 @@
+#pragma once
+
+#include "versioned_catalogue.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace transport_catalogue {
+
+// Следит за файлом с base_requests и при его изменении строит в фоновом потоке
+// новые справочник, маршрутизатор и рендерер, после чего атомарно публикует их
+class BaseFileWatcher {
+public:
+    BaseFileWatcher(std::filesystem::path path, VersionedCatalogue& versions,
+        std::chrono::milliseconds poll_interval = std::chrono::milliseconds(500));
+
+    BaseFileWatcher(const BaseFileWatcher&) = delete;
+    BaseFileWatcher& operator=(const BaseFileWatcher&) = delete;
+
+    ~BaseFileWatcher();
+
+private:
+    std::filesystem::path path_;
+    VersionedCatalogue& versions_;
+    std::chrono::milliseconds poll_interval_;
+    std::filesystem::file_time_type last_write_time_;
+    std::filesystem::file_time_type pending_write_time_;
+    std::mutex mutex_;
+    std::condition_variable stop_cv_;
+    bool stop_requested_ = false;
+    std::thread thread_;
+
+    void Run();
+
+    void Reload();
+};
+
+std::unique_ptr<VersionedCatalogue> LoadVersionedCatalogue(const std::filesystem::path& path);
+
+// Загружает базу из base_path и отвечает на документы со stat_requests, поступающие из input
+// по одному на строку, пока в фоне подхватываются изменения base_path. Каждый ответ
+// выводится одной строкой. Обновления из документов с base_requests действуют до следующего
+// изменения base_path: база тогда строится заново из файла
+int ServeWithHotReload(const std::filesystem::path& base_path, std::istream& input, std::ostream& output);
+
+// Проверяет перенос фрагментов карты при перезагрузке: строит базу из base_path, отрисовывает
+// карту, заменяет базу данными из updated_path так же, как при изменении файла, и сравнивает
+// карту новой версии с отрисованной заново. Возвращает 0, если карты совпадают байт в байт
+int CheckMapReuse(const std::filesystem::path& base_path, const std::filesystem::path& updated_path,
+    std::ostream& output);
+
+} // namespace transport_catalogue
\ No newline at end of file
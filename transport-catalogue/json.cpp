@@ -1,259 +1,804 @@
 #include "json.h"
+#include "json_writer.h"
+
+#include <charconv>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 using namespace std;
 
 namespace json {
 
-Node LoadNode(std::istream& input);
+namespace {
 
-std::string ParseString(std::istream& input) {
-    std::string s;
-    char c;
-    while (input.get(c) && c != ' ' && c != '\n' && c != '\t' && c != '\r') {
-        if (c == ',' || c == ']' || c == '}') {
-            input.putback(c);
-            break;
+bool IsSpace(char c) {
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r';
+}
+
+bool IsDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// Пропускает пробельные символы, обрабатывая по 16 байт за раз
+const char* SkipSpaces(const char* pos, const char* end) {
+#ifdef __SSE2__
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i carriage_return = _mm_set1_epi8('\r');
+    while (end - pos >= 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+        const __m128i spaces = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, space), _mm_cmpeq_epi8(chunk, newline)),
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, tab), _mm_cmpeq_epi8(chunk, carriage_return)));
+        const unsigned mask = ~static_cast<unsigned>(_mm_movemask_epi8(spaces)) & 0xFFFFu;
+        if (mask != 0) {
+            return pos + __builtin_ctz(mask);
         }
+        pos += 16;
+    }
+#endif
+    while (pos != end && IsSpace(*pos)) {
+        ++pos;
+    }
+    return pos;
+}
 
-        s += static_cast<char>(c);
+// Ищет первый символ, требующий внимания внутри строкового литерала: ", \, \n или \r
+const char* FindStringSpecial(const char* pos, const char* end) {
+#ifdef __SSE2__
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i carriage_return = _mm_set1_epi8('\r');
+    while (end - pos >= 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+        const __m128i special = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, newline), _mm_cmpeq_epi8(chunk, carriage_return)));
+        const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(special));
+        if (mask != 0) {
+            return pos + __builtin_ctz(mask);
+        }
+        pos += 16;
+    }
+#endif
+    while (pos != end && *pos != '"' && *pos != '\\' && *pos != '\n' && *pos != '\r') {
+        ++pos;
     }
-    return s;
+    return pos;
 }
 
-nullptr_t LoadNull(std::istream& input) {
-    if (ParseString(input) == "null"s) {
-        return nullptr;
-    } else {
-        throw ParsingError("Failed to read null from stream"s);
+// Ищет первый символ, который открывает строку или меняет вложенность: ", [, ], { или }
+const char* FindStructural(const char* pos, const char* end) {
+#ifdef __SSE2__
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i open_square = _mm_set1_epi8('[');
+    const __m128i close_square = _mm_set1_epi8(']');
+    const __m128i open_curly = _mm_set1_epi8('{');
+    const __m128i close_curly = _mm_set1_epi8('}');
+    while (end - pos >= 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+        const __m128i structural = _mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+            _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, open_square), _mm_cmpeq_epi8(chunk, close_square)),
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, open_curly), _mm_cmpeq_epi8(chunk, close_curly))));
+        const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(structural));
+        if (mask != 0) {
+            return pos + __builtin_ctz(mask);
+        }
+        pos += 16;
+    }
+#endif
+    while (pos != end && *pos != '"' && *pos != '[' && *pos != ']' && *pos != '{' && *pos != '}') {
+        ++pos;
     }
+    return pos;
 }
 
-bool LoadBool(std::istream& input) {
-    std::string s = ParseString(input);
-    if (s == "true"s) {
-        return true;
-    } else if (s == "false"s) {
-        return false;
+void AppendUtf8(std::string& s, uint32_t code_point) {
+    if (code_point < 0x80) {
+        s.push_back(static_cast<char>(code_point));
+    } else if (code_point < 0x800) {
+        s.push_back(static_cast<char>(0xC0 | (code_point >> 6)));
+        s.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+    } else if (code_point < 0x10000) {
+        s.push_back(static_cast<char>(0xE0 | (code_point >> 12)));
+        s.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+        s.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
     } else {
-        throw ParsingError("Failed to read bool from stream"s);
+        s.push_back(static_cast<char>(0xF0 | (code_point >> 18)));
+        s.push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+        s.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+        s.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
     }
 }
 
 using Number = std::variant<int, double>;
 
-Number LoadNumber(std::istream& input) {
-    using namespace std::literals;
+bool IsDelimiter(char c) {
+    return IsSpace(c) || c == ',' || c == ']' || c == '}';
+}
 
-    std::string parsed_num;
+bool IsNumberChar(char c) {
+    return IsDigit(c) || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+}
 
-    // Считывает в parsed_num очередной символ из input
-    auto read_char = [&parsed_num, &input] {
-        parsed_num += static_cast<char>(input.get());
-        if (!input) {
-            throw ParsingError("Failed to read number from stream"s);
-        }
-    };
+// Проверяет, что с pos начинается literal, за которым следует разделитель или конец текста
+void ReadLiteral(const char*& pos, const char* end, std::string_view literal) {
+    if (static_cast<size_t>(end - pos) < literal.size()
+        || std::string_view(pos, literal.size()) != literal) {
+        throw ParsingError("Failed to read "s + std::string(literal) + " from stream"s);
+    }
+    pos += literal.size();
+    if (pos != end && !IsDelimiter(*pos)) {
+        throw ParsingError("Failed to read "s + std::string(literal) + " from stream"s);
+    }
+}
 
-    // Считывает одну или более цифр в parsed_num из input
-    auto read_digits = [&input, read_char] {
-        if (!std::isdigit(input.peek())) {
+Number ReadNumber(const char*& pos, const char* end) {
+    const char* begin = pos;
+    auto read_digits = [&pos, end] {
+        if (pos == end || !IsDigit(*pos)) {
             throw ParsingError("A digit is expected"s);
         }
-        while (std::isdigit(input.peek())) {
-            read_char();
+        while (pos != end && IsDigit(*pos)) {
+            ++pos;
         }
     };
 
-    if (input.peek() == '-') {
-        read_char();
+    if (pos != end && *pos == '-') {
+        ++pos;
     }
-    // Парсим целую часть числа
-    if (input.peek() == '0') {
-        read_char();
-        // После 0 в JSON не могут идти другие цифры
+    // После 0 в JSON не могут идти другие цифры
+    if (pos != end && *pos == '0') {
+        ++pos;
     } else {
         read_digits();
     }
-
     bool is_int = true;
-    // Парсим дробную часть числа
-    if (input.peek() == '.') {
-        read_char();
+    if (pos != end && *pos == '.') {
+        ++pos;
         read_digits();
         is_int = false;
     }
-
-    // Парсим экспоненциальную часть числа
-    if (int ch = input.peek(); ch == 'e' || ch == 'E') {
-        read_char();
-        if (ch = input.peek(); ch == '+' || ch == '-') {
-            read_char();
+    if (pos != end && (*pos == 'e' || *pos == 'E')) {
+        ++pos;
+        if (pos != end && (*pos == '+' || *pos == '-')) {
+            ++pos;
         }
         read_digits();
         is_int = false;
     }
 
-    try {
-        if (is_int) {
-            // Сначала пробуем преобразовать строку в int
-            try {
-                return std::stoi(parsed_num);
-            } catch (...) {
-                // В случае неудачи, например, при переполнении,
-                // код ниже попробует преобразовать строку в double
+    if (is_int) {
+        int value = 0;
+        if (auto [ptr, ec] = std::from_chars(begin, pos, value); ec == std::errc() && ptr == pos) {
+            return value;
+        }
+        // При переполнении int число читается как double
+    }
+    double value = 0.0;
+    if (auto [ptr, ec] = std::from_chars(begin, pos, value); ec != std::errc() || ptr != pos) {
+        throw ParsingError("Failed to convert "s + std::string(begin, pos) + " to number"s);
+    }
+    return value;
+}
+
+uint32_t ReadHex4(const char*& pos, const char* end) {
+    uint32_t value = 0;
+    if (end - pos < 4 || std::from_chars(pos, pos + 4, value, 16).ptr != pos + 4) {
+        throw ParsingError("Invalid \\u escape sequence"s);
+    }
+    pos += 4;
+    return value;
+}
+
+// Разбирает escape-последовательность, следующую за обратной косой чертой, и дописывает символ в s
+void ReadEscape(const char*& pos, const char* end, std::string& s) {
+    if (pos == end) {
+        throw ParsingError("String parsing error"s);
+    }
+    const char escaped_char = *pos++;
+    switch (escaped_char) {
+        case 'n':
+            s.push_back('\n');
+            break;
+        case 't':
+            s.push_back('\t');
+            break;
+        case 'r':
+            s.push_back('\r');
+            break;
+        case 'b':
+            s.push_back('\b');
+            break;
+        case 'f':
+            s.push_back('\f');
+            break;
+        case '"':
+        case '\\':
+        case '/':
+            s.push_back(escaped_char);
+            break;
+        case 'u': {
+            uint32_t code_point = ReadHex4(pos, end);
+            // Половина суррогатной пары не кодируется в UTF-8, поэтому принимаются только полные пары
+            if (code_point >= 0xD800 && code_point < 0xE000) {
+                if (code_point >= 0xDC00 || end - pos < 6 || pos[0] != '\\' || pos[1] != 'u') {
+                    throw ParsingError("Unpaired surrogate in \\u escape"s);
+                }
+                pos += 2;
+                const uint32_t low = ReadHex4(pos, end);
+                if (low < 0xDC00 || low >= 0xE000) {
+                    throw ParsingError("Unpaired surrogate in \\u escape"s);
+                }
+                code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
             }
+            AppendUtf8(s, code_point);
+            break;
         }
-        return std::stod(parsed_num);
-    } catch (...) {
-        throw ParsingError("Failed to convert "s + parsed_num + " to number"s);
+        default:
+            throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
     }
 }
 
-// Считывает содержимое строкового литерала JSON-документа
-// Функцию следует использовать после считывания открывающего символа ":
-std::string LoadString(std::istream& input) {
-    using namespace std::literals;
-    
-    auto it = std::istreambuf_iterator<char>(input);
-    auto end = std::istreambuf_iterator<char>();
-    std::string s;
+// Возвращает позицию за закрывающей кавычкой строки, содержимое которой начинается с pos
+const char* SkipString(const char* pos, const char* end) {
     while (true) {
-        if (it == end) {
-            // Поток закончился до того, как встретили закрывающую кавычку?
-            throw ParsingError("String parsing error");
-        }
-        const char ch = *it;
-        if (ch == '"') {
-            // Встретили закрывающую кавычку
-            ++it;
-            break;
-        } else if (ch == '\\') {
-            // Встретили начало escape-последовательности
-            ++it;
-            if (it == end) {
-                // Поток завершился сразу после символа обратной косой черты
-                throw ParsingError("String parsing error");
-            }
-            const char escaped_char = *(it);
-            // Обрабатываем одну из последовательностей: \\, \n, \t, \r, \"
-            switch (escaped_char) {
-                case 'n':
-                    s.push_back('\n');
-                    break;
-                case 't':
-                    s.push_back('\t');
-                    break;
-                case 'r':
-                    s.push_back('\r');
-                    break;
-                case '"':
-                    s.push_back('"');
-                    break;
-                case '\\':
-                    s.push_back('\\');
-                    break;
-                default:
-                    // Встретили неизвестную escape-последовательность
-                    throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
-            }
-        } else if (ch == '\n' || ch == '\r') {
-            // Строковый литерал внутри- JSON не может прерываться символами \r или \n
-            throw ParsingError("Unexpected end of line"s);
-        } else {
-            // Просто считываем очередной символ и помещаем его в результирующую строку
-            s.push_back(ch);
+        pos = FindStringSpecial(pos, end);
+        if (pos == end) {
+            throw ParsingError("String parsing error"s);
+        }
+        if (*pos == '"') {
+            return pos + 1;
+        }
+        // Содержимое escape-последовательностей и переводы строк проверит полный разбор
+        pos += *pos == '\\' ? 2 : 1;
+        if (pos > end) {
+            throw ParsingError("String parsing error"s);
         }
-        ++it;
     }
+}
 
-    return s;
+// Возвращает позицию за значением, начинающимся с pos. Разбирается только структура:
+// вложенность скобок и границы строк
+const char* SkipValue(const char* pos, const char* end) {
+    if (pos == end) {
+        throw ParsingError("Unexpected end of JSON document"s);
+    }
+    if (*pos != '[' && *pos != '{' && *pos != '"') {
+        while (pos != end && !IsDelimiter(*pos)) {
+            ++pos;
+        }
+        return pos;
+    }
+    size_t depth = 0;
+    while (true) {
+        pos = FindStructural(pos, end);
+        if (pos == end) {
+            throw ParsingError("Unexpected end of JSON document"s);
+        }
+        const char c = *pos++;
+        if (c == '"') {
+            pos = SkipString(pos, end);
+        } else if (c == '[' || c == '{') {
+            ++depth;
+        } else {
+            --depth;
+        }
+        if (depth == 0) {
+            return pos;
+        }
+    }
 }
 
-Array LoadArray(istream& input) {
-    Array result;
-    bool brace_found = false;
-    for (char c; input >> c;) {
-        if (c == ']') {
-            brace_found = true;
-            break;
+// Разбирает JSON-документ, целиком находящийся в непрерывном буфере
+class Parser {
+public:
+    explicit Parser(std::string_view text)
+        : pos_(text.data())
+        , end_(text.data() + text.size()) {
+    }
+
+    Node ParseDocument() {
+        Node root = ParseNode();
+        pos_ = SkipSpaces(pos_, end_);
+        if (pos_ != end_) {
+            throw ParsingError("Unexpected characters after JSON document"s);
         }
-        if (c != ',') {
-            input.putback(c);
+        return root;
+    }
+
+private:
+    const char* pos_;
+    const char* end_;
+
+    char NextToken(const char* error) {
+        pos_ = SkipSpaces(pos_, end_);
+        if (pos_ == end_) {
+            throw ParsingError(error);
         }
+        return *pos_;
+    }
 
-        result.push_back(LoadNode(input));
+    Node ParseNode() {
+        const char c = NextToken("Unexpected end of JSON document");
+        if (c == '[') {
+            ++pos_;
+            return Node(ParseArray());
+        } else if (c == '{') {
+            ++pos_;
+            return Node(ParseDict());
+        } else if (c == '"') {
+            ++pos_;
+            return Node(ParseString());
+        } else if (c == 'n') {
+            ParseLiteral("null"sv);
+            return Node(nullptr);
+        } else if (c == 't') {
+            ParseLiteral("true"sv);
+            return Node(true);
+        } else if (c == 'f') {
+            ParseLiteral("false"sv);
+            return Node(false);
+        }
+        Number number = ParseNumber();
+        if (holds_alternative<int>(number)) {
+            return Node(get<int>(number));
+        }
+        return Node(get<double>(number));
     }
-    if (brace_found) {
-        return result;
-    } else {
-        throw ParsingError("Failed to read array from stream"s);
+
+    void ParseLiteral(std::string_view literal) {
+        ReadLiteral(pos_, end_, literal);
     }
-}
 
-Dict LoadDict(istream& input) {
-    Dict result;
-    bool brace_found = false;
-    for (char c; input >> c;) {
-        if (c == '}') {
-            brace_found = true;
-            break;
+    Number ParseNumber() {
+        return ReadNumber(pos_, end_);
+    }
+
+    // Считывает содержимое строкового литерала после открывающей кавычки
+    std::string ParseString() {
+        std::string s;
+        while (true) {
+            const char* special = FindStringSpecial(pos_, end_);
+            if (special == end_) {
+                throw ParsingError("String parsing error"s);
+            }
+            if (*special == '"') {
+                if (s.empty()) {
+                    s.assign(pos_, special);
+                } else {
+                    s.append(pos_, special);
+                }
+                pos_ = special + 1;
+                return s;
+            }
+            if (*special != '\\') {
+                // Строковый литерал внутри JSON не может прерываться символами \r или \n
+                throw ParsingError("Unexpected end of line"s);
+            }
+            s.append(pos_, special);
+            pos_ = special + 1;
+            ReadEscape(pos_, end_, s);
+        }
+    }
+
+    Array ParseArray() {
+        Array result;
+        if (NextToken("Failed to read array from stream") == ']') {
+            ++pos_;
+            return result;
         }
-        if (c == ',') {
-            input >> c;
+        while (true) {
+            result.push_back(ParseNode());
+            const char c = NextToken("Failed to read array from stream");
+            ++pos_;
+            if (c == ']') {
+                return result;
+            }
+            if (c != ',') {
+                throw ParsingError("Failed to read array from stream"s);
+            }
+        }
+    }
+
+    Dict ParseDict() {
+        Dict result;
+        if (NextToken("Failed to read map from stream") == '}') {
+            ++pos_;
+            return result;
+        }
+        while (true) {
+            if (NextToken("Failed to read map from stream") != '"') {
+                throw ParsingError("Failed to read map key from stream"s);
+            }
+            ++pos_;
+            std::string key = ParseString();
+            if (NextToken("Failed to read map from stream") != ':') {
+                throw ParsingError("Failed to read map from stream"s);
+            }
+            ++pos_;
+            result.emplace(std::move(key), ParseNode());
+            const char c = NextToken("Failed to read map from stream");
+            ++pos_;
+            if (c == '}') {
+                return result;
+            }
+            if (c != ',') {
+                throw ParsingError("Failed to read map from stream"s);
+            }
         }
+    }
+};
 
-        string key = LoadString(input);
-        input >> c;
-        result.insert({move(key), LoadNode(input)});
+// Разбирает документ из непрерывного буфера в плоский массив узлов
+class FlatParser {
+public:
+    FlatParser(std::string_view text, std::vector<FlatEntry>& entries, std::deque<std::string>& decoded_strings)
+        : pos_(text.data())
+        , end_(text.data() + text.size())
+        , entries_(entries)
+        , decoded_strings_(decoded_strings) {
     }
-    if (brace_found) {
-        return result;
-    } else {
-        throw ParsingError("Failed to read map from stream"s);
+
+    void ParseDocument() {
+        ParseValue();
+        pos_ = SkipSpaces(pos_, end_);
+        if (pos_ != end_) {
+            throw ParsingError("Unexpected characters after JSON document"s);
+        }
+    }
+
+private:
+    const char* pos_;
+    const char* end_;
+    std::vector<FlatEntry>& entries_;
+    std::deque<std::string>& decoded_strings_;
+
+    char NextToken(const char* error) {
+        pos_ = SkipSpaces(pos_, end_);
+        if (pos_ == end_) {
+            throw ParsingError(error);
+        }
+        return *pos_;
     }
-}
 
-void SkipSpacesAndEscapes(std::istream& input) {
-    char c;
-    while (input.get(c)) {
-        if (c == ' ' || c == '\n' || c == '\t' || c == '\r') {
-            continue;
+    void ParseValue() {
+        const char c = NextToken("Unexpected end of JSON document");
+        const size_t index = entries_.size();
+        entries_.emplace_back();
+        if (c == '[') {
+            ++pos_;
+            entries_[index].type = FlatEntry::Type::ARRAY;
+            entries_[index].size = ParseArray();
+        } else if (c == '{') {
+            ++pos_;
+            entries_[index].type = FlatEntry::Type::DICT;
+            entries_[index].size = ParseDict();
+        } else if (c == '"') {
+            ++pos_;
+            ParseString(entries_[index]);
+        } else if (c == 'n') {
+            ReadLiteral(pos_, end_, "null"sv);
+        } else if (c == 't') {
+            ReadLiteral(pos_, end_, "true"sv);
+            entries_[index].type = FlatEntry::Type::BOOL;
+            entries_[index].bool_value = true;
+        } else if (c == 'f') {
+            ReadLiteral(pos_, end_, "false"sv);
+            entries_[index].type = FlatEntry::Type::BOOL;
+            entries_[index].bool_value = false;
         } else {
-            input.putback(c);
-            break;
+            const Number number = ReadNumber(pos_, end_);
+            if (holds_alternative<int>(number)) {
+                entries_[index].type = FlatEntry::Type::INT;
+                entries_[index].int_value = get<int>(number);
+            } else {
+                entries_[index].type = FlatEntry::Type::DOUBLE;
+                entries_[index].double_value = get<double>(number);
+            }
         }
+        entries_[index].skip = static_cast<uint32_t>(entries_.size() - index);
     }
-}
 
-Node LoadNode(istream& input) {
-    char c;
-    input >> c;
+    // Строка без escape-последовательностей остаётся ссылкой на исходный текст
+    void ParseString(FlatEntry& entry) {
+        entry.type = FlatEntry::Type::STRING;
+        const char* special = FindStringSpecial(pos_, end_);
+        if (special != end_ && *special == '"') {
+            entry.string_data = pos_;
+            entry.size = static_cast<uint32_t>(special - pos_);
+            pos_ = special + 1;
+            return;
+        }
+        std::string& decoded = decoded_strings_.emplace_back();
+        while (true) {
+            if (special == end_) {
+                throw ParsingError("String parsing error"s);
+            }
+            decoded.append(pos_, special);
+            pos_ = special + 1;
+            if (*special == '"') {
+                break;
+            }
+            if (*special != '\\') {
+                // Строковый литерал внутри JSON не может прерываться символами \r или \n
+                throw ParsingError("Unexpected end of line"s);
+            }
+            ReadEscape(pos_, end_, decoded);
+            special = FindStringSpecial(pos_, end_);
+        }
+        entry.string_data = decoded.data();
+        entry.size = static_cast<uint32_t>(decoded.size());
+    }
 
-    if (c == '[') {
-        return Node(LoadArray(input));
-    } else if (c == '{') {
-        return Node(LoadDict(input));
-    } else if (c == '"') {
-        return Node(LoadString(input));
-    } else {
-        input.putback(c);
-        SkipSpacesAndEscapes(input);
-        auto p = input.peek();
-        if (p == 'n') {
-            return Node(LoadNull(input));
-        } else if (p == 't' || p == 'f') {
-            return Node(LoadBool(input));
+    uint32_t ParseArray() {
+        uint32_t count = 0;
+        if (NextToken("Failed to read array from stream") == ']') {
+            ++pos_;
+            return count;
+        }
+        while (true) {
+            ParseValue();
+            ++count;
+            const char c = NextToken("Failed to read array from stream");
+            ++pos_;
+            if (c == ']') {
+                return count;
+            }
+            if (c != ',') {
+                throw ParsingError("Failed to read array from stream"s);
+            }
+        }
+    }
+
+    uint32_t ParseDict() {
+        uint32_t count = 0;
+        if (NextToken("Failed to read map from stream") == '}') {
+            ++pos_;
+            return count;
+        }
+        while (true) {
+            if (NextToken("Failed to read map from stream") != '"') {
+                throw ParsingError("Failed to read map key from stream"s);
+            }
+            ++pos_;
+            ParseString(entries_.emplace_back());
+            if (NextToken("Failed to read map from stream") != ':') {
+                throw ParsingError("Failed to read map from stream"s);
+            }
+            ++pos_;
+            ParseValue();
+            ++count;
+            const char c = NextToken("Failed to read map from stream");
+            ++pos_;
+            if (c == '}') {
+                return count;
+            }
+            if (c != ',') {
+                throw ParsingError("Failed to read map from stream"s);
+            }
+        }
+    }
+};
+
+// Разбирает документ из потока, держа в памяти только текущую порцию входных данных
+// и значение, которое через неё переходит
+class StreamParser {
+public:
+    StreamParser(std::istream& input, Handler& handler)
+        : input_(input)
+        , handler_(handler) {
+    }
+
+    void ParseDocument() {
+        ParseValue();
+        if (SkipSpacesAndFill()) {
+            throw ParsingError("Unexpected characters after JSON document"s);
+        }
+    }
+
+private:
+    static constexpr size_t CHUNK_SIZE = 1 << 16;
+    // Самая длинная escape-последовательность: \uXXXX\uXXXX без начальной косой черты
+    static constexpr size_t MAX_ESCAPE_SIZE = 11;
+
+    std::istream& input_;
+    Handler& handler_;
+    std::string buffer_;
+    const char* pos_ = nullptr;
+    const char* end_ = nullptr;
+    bool eof_ = false;
+    // Строка или число, которые начались в одной порции данных и продолжаются в следующей
+    std::string token_;
+
+    // Дочитывает поток, пока после pos_ не окажется хотя бы size символов.
+    // Непрочитанный остаток буфера переносится в его начало
+    bool Fill(size_t size) {
+        while (static_cast<size_t>(end_ - pos_) < size && !eof_) {
+            const size_t rest = end_ - pos_;
+            if (rest > 0) {
+                std::memmove(buffer_.data(), pos_, rest);
+            }
+            buffer_.resize(rest + CHUNK_SIZE);
+            input_.read(buffer_.data() + rest, CHUNK_SIZE);
+            const auto count = static_cast<size_t>(input_.gcount());
+            eof_ = count == 0;
+            buffer_.resize(rest + count);
+            pos_ = buffer_.data();
+            end_ = pos_ + buffer_.size();
+        }
+        return static_cast<size_t>(end_ - pos_) >= size;
+    }
+
+    bool SkipSpacesAndFill() {
+        while (true) {
+            pos_ = SkipSpaces(pos_, end_);
+            if (pos_ != end_) {
+                return true;
+            }
+            if (!Fill(1)) {
+                return false;
+            }
+        }
+    }
+
+    char NextToken(const char* error) {
+        if (!SkipSpacesAndFill()) {
+            throw ParsingError(error);
+        }
+        return *pos_;
+    }
+
+    void ParseValue() {
+        const char c = NextToken("Unexpected end of JSON document");
+        if (c == '[') {
+            ++pos_;
+            ParseArray();
+        } else if (c == '{') {
+            ++pos_;
+            ParseDict();
+        } else if (c == '"') {
+            ++pos_;
+            handler_.String(ParseString());
+        } else if (c == 'n') {
+            ParseLiteral("null"sv);
+            handler_.Null();
+        } else if (c == 't') {
+            ParseLiteral("true"sv);
+            handler_.Bool(true);
+        } else if (c == 'f') {
+            ParseLiteral("false"sv);
+            handler_.Bool(false);
         } else {
-            Number number = LoadNumber(input);
-            if (holds_alternative<double>(number)) {
-                return Node(get<double>(number));
-            } else if (holds_alternative<int>(number)) {
-                return Node(get<int>(number));
+            ParseNumber();
+        }
+    }
+
+    void ParseLiteral(std::string_view literal) {
+        Fill(literal.size() + 1);
+        ReadLiteral(pos_, end_, literal);
+    }
+
+    void ParseNumber() {
+        token_.clear();
+        while (true) {
+            const char* begin = pos_;
+            while (pos_ != end_ && IsNumberChar(*pos_)) {
+                ++pos_;
+            }
+            token_.append(begin, pos_);
+            if (pos_ != end_ || !Fill(1)) {
+                break;
+            }
+        }
+        const char* pos = token_.data();
+        const char* end = pos + token_.size();
+        const Number number = ReadNumber(pos, end);
+        if (pos != end) {
+            throw ParsingError("Failed to convert "s + token_ + " to number"s);
+        }
+        if (holds_alternative<int>(number)) {
+            handler_.Int(get<int>(number));
+        } else {
+            handler_.Double(get<double>(number));
+        }
+    }
+
+    // Считывает строковый литерал после открывающей кавычки. Результат действителен
+    // до следующего чтения из потока
+    std::string_view ParseString() {
+        token_.clear();
+        while (true) {
+            const char* special = FindStringSpecial(pos_, end_);
+            if (special == end_) {
+                token_.append(pos_, end_);
+                pos_ = end_;
+                if (!Fill(1)) {
+                    throw ParsingError("String parsing error"s);
+                }
+                continue;
+            }
+            if (*special == '"') {
+                std::string_view result;
+                if (token_.empty()) {
+                    result = std::string_view(pos_, special - pos_);
+                } else {
+                    token_.append(pos_, special);
+                    result = token_;
+                }
+                pos_ = special + 1;
+                return result;
+            }
+            if (*special != '\\') {
+                // Строковый литерал внутри JSON не может прерываться символами \r или \n
+                throw ParsingError("Unexpected end of line"s);
+            }
+            token_.append(pos_, special);
+            pos_ = special + 1;
+            Fill(MAX_ESCAPE_SIZE);
+            ReadEscape(pos_, end_, token_);
+        }
+    }
+
+    void ParseArray() {
+        handler_.StartArray();
+        if (NextToken("Failed to read array from stream") == ']') {
+            ++pos_;
+            handler_.EndArray();
+            return;
+        }
+        while (true) {
+            ParseValue();
+            const char c = NextToken("Failed to read array from stream");
+            ++pos_;
+            if (c == ']') {
+                handler_.EndArray();
+                return;
+            }
+            if (c != ',') {
+                throw ParsingError("Failed to read array from stream"s);
             }
         }
     }
-    return Node{};
-}
+
+    void ParseDict() {
+        handler_.StartDict();
+        if (NextToken("Failed to read map from stream") == '}') {
+            ++pos_;
+            handler_.EndDict();
+            return;
+        }
+        while (true) {
+            if (NextToken("Failed to read map from stream") != '"') {
+                throw ParsingError("Failed to read map key from stream"s);
+            }
+            ++pos_;
+            handler_.Key(ParseString());
+            if (NextToken("Failed to read map from stream") != ':') {
+                throw ParsingError("Failed to read map from stream"s);
+            }
+            ++pos_;
+            ParseValue();
+            const char c = NextToken("Failed to read map from stream");
+            ++pos_;
+            if (c == '}') {
+                handler_.EndDict();
+                return;
+            }
+            if (c != ',') {
+                throw ParsingError("Failed to read map from stream"s);
+            }
+        }
+    }
+};
+
+} // namespace
 
 // Контекст вывода, хранит ссылку на поток вывода и текущий отсуп
 struct PrintContext {
@@ -291,30 +836,12 @@ void PrintValue<bool>(const bool& value, const PrintContext& ctx) {
 }
 
 void PrintString(const std::string& str, std::ostream& out) {
-    out << '"';
-    for (char ch : str) {
-        switch (ch) {
-            case '\n':
-                out << "\\n";
-                break;
-            case '\t':
-                out << "\\t";
-                break;
-            case '\r':
-                out << "\\r";
-                break;
-            case '"':
-                out << "\\\"";
-                break;
-            case '\\':
-                out << "\\\\";
-                break;
-            default:
-                out << ch;
-                break;
-        }
-    }
-    out << '"';
+    std::string escaped;
+    escaped.reserve(str.size() + 2);
+    escaped += '"';
+    AppendEscaped(escaped, str);
+    escaped += '"';
+    out.write(escaped.data(), static_cast<std::streamsize>(escaped.size()));
 }
 
 template <>
@@ -380,8 +907,121 @@ const Node& Document::GetRoot() const {
     return root_;
 }
 
+std::string ReadAll(std::istream& input) {
+    std::string buffer;
+    char chunk[1 << 16];
+    while (input.read(chunk, sizeof(chunk)) || input.gcount() > 0) {
+        buffer.append(chunk, static_cast<size_t>(input.gcount()));
+    }
+    return buffer;
+}
+
+std::vector<std::string_view> SplitArray(std::string_view text) {
+    const char* const end = text.data() + text.size();
+    const char* pos = SkipSpaces(text.data(), end);
+    if (pos == end || *pos != '[') {
+        throw ParsingError("Failed to read array from stream"s);
+    }
+    std::vector<std::string_view> result;
+    pos = SkipSpaces(pos + 1, end);
+    if (pos != end && *pos == ']') {
+        ++pos;
+    } else {
+        while (true) {
+            const char* value_end = SkipValue(pos, end);
+            result.emplace_back(pos, value_end - pos);
+            pos = SkipSpaces(value_end, end);
+            if (pos == end) {
+                throw ParsingError("Failed to read array from stream"s);
+            }
+            const char c = *pos++;
+            if (c == ']') {
+                break;
+            }
+            if (c != ',') {
+                throw ParsingError("Failed to read array from stream"s);
+            }
+            pos = SkipSpaces(pos, end);
+        }
+    }
+    if (SkipSpaces(pos, end) != end) {
+        throw ParsingError("Unexpected characters after JSON document"s);
+    }
+    return result;
+}
+
+std::vector<std::pair<std::string, std::string_view>> SplitDict(std::string_view text) {
+    const char* const end = text.data() + text.size();
+    const char* pos = SkipSpaces(text.data(), end);
+    if (pos == end || *pos != '{') {
+        throw ParsingError("Failed to read map from stream"s);
+    }
+    std::vector<std::pair<std::string, std::string_view>> result;
+    pos = SkipSpaces(pos + 1, end);
+    if (pos != end && *pos == '}') {
+        ++pos;
+    } else {
+        while (true) {
+            if (pos == end || *pos != '"') {
+                throw ParsingError("Failed to read map key from stream"s);
+            }
+            const char* key_end = SkipValue(pos, end);
+            std::string key = Parser(std::string_view(pos, key_end - pos)).ParseDocument().AsString();
+            pos = SkipSpaces(key_end, end);
+            if (pos == end || *pos != ':') {
+                throw ParsingError("Failed to read map from stream"s);
+            }
+            pos = SkipSpaces(pos + 1, end);
+            const char* value_end = SkipValue(pos, end);
+            result.emplace_back(std::move(key), std::string_view(pos, value_end - pos));
+            pos = SkipSpaces(value_end, end);
+            if (pos == end) {
+                throw ParsingError("Failed to read map from stream"s);
+            }
+            const char c = *pos++;
+            if (c == '}') {
+                break;
+            }
+            if (c != ',') {
+                throw ParsingError("Failed to read map from stream"s);
+            }
+            pos = SkipSpaces(pos, end);
+        }
+    }
+    if (SkipSpaces(pos, end) != end) {
+        throw ParsingError("Unexpected characters after JSON document"s);
+    }
+    return result;
+}
+
+FlatDocument::FlatDocument(std::string_view text) {
+    Parse(text);
+}
+
+void FlatDocument::Parse(std::string_view text) {
+    entries_.clear();
+    decoded_strings_.clear();
+    FlatParser(text, entries_, decoded_strings_).ParseDocument();
+}
+
+FlatNode FlatDocument::GetRoot() const {
+    using namespace std::literals;
+    if (entries_.empty()) {
+        throw std::logic_error("Document is empty"s);
+    }
+    return FlatNode(entries_.data());
+}
+
 Document Load(std::istream& input) {
-    return Document{LoadNode(input)};
+    return Load(ReadAll(input));
+}
+
+Document Load(std::string_view text) {
+    return Document{Parser(text).ParseDocument()};
+}
+
+void Parse(std::istream& input, Handler& handler) {
+    StreamParser(input, handler).ParseDocument();
 }
 
 void Print(const Document& doc, std::ostream& output) {
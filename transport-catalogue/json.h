@@ -1,9 +1,14 @@
 #pragma once
 
 #include <algorithm>
+#include <cstdint>
+#include <deque>
 #include <iostream>
 #include <map>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -165,8 +170,265 @@ inline bool operator!=(const Document& lhs, const Document& rhs) {
     return !(lhs == rhs);
 }
 
+// Элемент компактного документа. Узлы документа лежат подряд в порядке обхода в глубину:
+// за массивом следуют его элементы, за словарём — пары из ключа и значения
+struct FlatEntry {
+    enum class Type : uint8_t {
+        NUL,
+        ARRAY,
+        DICT,
+        BOOL,
+        INT,
+        DOUBLE,
+        STRING
+    };
+
+    Type type = Type::NUL;
+    // Число элементов массива, пар словаря или длина строки
+    uint32_t size = 0;
+    // Число элементов, занимаемых узлом вместе с вложенными, то есть смещение до следующего соседа
+    uint32_t skip = 1;
+    union {
+        bool bool_value;
+        int int_value;
+        double double_value;
+        const char* string_data;
+    };
+};
+
+// Лёгкая ссылка на узел FlatDocument. Действительна, пока жив документ
+class FlatNode {
+public:
+    class ArrayIterator {
+    public:
+        explicit ArrayIterator(const FlatEntry* entry)
+            : entry_(entry) {
+        }
+
+        FlatNode operator*() const {
+            return FlatNode(entry_);
+        }
+
+        ArrayIterator& operator++() {
+            entry_ += entry_->skip;
+            return *this;
+        }
+
+        bool operator!=(const ArrayIterator& other) const {
+            return entry_ != other.entry_;
+        }
+
+    private:
+        const FlatEntry* entry_;
+    };
+
+    class DictIterator {
+    public:
+        explicit DictIterator(const FlatEntry* entry)
+            : entry_(entry) {
+        }
+
+        std::pair<std::string_view, FlatNode> operator*() const {
+            return {FlatNode(entry_).AsString(), FlatNode(entry_ + 1)};
+        }
+
+        DictIterator& operator++() {
+            entry_ += 1 + entry_[1].skip;
+            return *this;
+        }
+
+        bool operator!=(const DictIterator& other) const {
+            return entry_ != other.entry_;
+        }
+
+    private:
+        const FlatEntry* entry_;
+    };
+
+    template <typename Iterator>
+    class Range {
+    public:
+        explicit Range(const FlatEntry* entry)
+            : entry_(entry) {
+        }
+
+        Iterator begin() const {
+            return Iterator(entry_ + 1);
+        }
+
+        Iterator end() const {
+            return Iterator(entry_ + entry_->skip);
+        }
+
+        size_t size() const {
+            return entry_->size;
+        }
+
+        bool empty() const {
+            return entry_->size == 0;
+        }
+
+        // Доступ по индексу проходит элементы по порядку
+        auto at(size_t index) const {
+            using namespace std::literals;
+            if (index >= size()) {
+                throw std::out_of_range("Flat node index is out of range"s);
+            }
+            auto it = begin();
+            for (size_t i = 0; i < index; ++i) {
+                ++it;
+            }
+            return *it;
+        }
+
+    private:
+        const FlatEntry* entry_;
+    };
+
+    using Array = Range<ArrayIterator>;
+    using Dict = Range<DictIterator>;
+
+    explicit FlatNode(const FlatEntry* entry)
+        : entry_(entry) {
+    }
+
+    bool IsNull() const {
+        return entry_->type == FlatEntry::Type::NUL;
+    }
+
+    bool IsInt() const {
+        return entry_->type == FlatEntry::Type::INT;
+    }
+
+    bool IsDouble() const {
+        return IsInt() || IsPureDouble();
+    }
+
+    bool IsPureDouble() const {
+        return entry_->type == FlatEntry::Type::DOUBLE;
+    }
+
+    bool IsBool() const {
+        return entry_->type == FlatEntry::Type::BOOL;
+    }
+
+    bool IsString() const {
+        return entry_->type == FlatEntry::Type::STRING;
+    }
+
+    bool IsArray() const {
+        return entry_->type == FlatEntry::Type::ARRAY;
+    }
+
+    bool IsMap() const {
+        return entry_->type == FlatEntry::Type::DICT;
+    }
+
+    int AsInt() const {
+        CheckType(IsInt());
+        return entry_->int_value;
+    }
+
+    double AsDouble() const {
+        CheckType(IsDouble());
+        return IsInt() ? entry_->int_value : entry_->double_value;
+    }
+
+    bool AsBool() const {
+        CheckType(IsBool());
+        return entry_->bool_value;
+    }
+
+    std::string_view AsString() const {
+        CheckType(IsString());
+        return std::string_view(entry_->string_data, entry_->size);
+    }
+
+    Array AsArray() const {
+        CheckType(IsArray());
+        return Array(entry_);
+    }
+
+    Dict AsMap() const {
+        CheckType(IsMap());
+        return Dict(entry_);
+    }
+
+private:
+    const FlatEntry* entry_;
+
+    static void CheckType(bool matches) {
+        using namespace std::literals;
+        if (!matches) {
+            throw std::logic_error("Unexpected type access"s);
+        }
+    }
+};
+
+// Компактный документ: все узлы хранятся в одном массиве, ключи и строки без
+// escape-последовательностей ссылаются на исходный текст, поэтому он должен пережить документ.
+// Повторный разбор в тот же документ переиспользует выделенную память
+class FlatDocument {
+public:
+    FlatDocument() = default;
+
+    explicit FlatDocument(std::string_view text);
+
+    void Parse(std::string_view text);
+
+    FlatNode GetRoot() const;
+
+private:
+    std::vector<FlatEntry> entries_;
+    // Строки, в которых были escape-последовательности, хранятся раскодированными
+    std::deque<std::string> decoded_strings_;
+};
+
+// Получает события разбора по мере чтения документа, сам документ в памяти не строится
+class Handler {
+public:
+    virtual void StartDict() = 0;
+
+    virtual void Key(std::string_view key) = 0;
+
+    virtual void EndDict() = 0;
+
+    virtual void StartArray() = 0;
+
+    virtual void EndArray() = 0;
+
+    virtual void String(std::string_view value) = 0;
+
+    virtual void Int(int value) = 0;
+
+    virtual void Double(double value) = 0;
+
+    virtual void Bool(bool value) = 0;
+
+    virtual void Null() = 0;
+
+protected:
+    ~Handler() = default;
+};
+
+// Читает поток целиком в память
+std::string ReadAll(std::istream& input);
+
+// Находит границы элементов массива, не разбирая их. Вложенные значения
+// проверяются только на парность скобок и кавычек
+std::vector<std::string_view> SplitArray(std::string_view text);
+
+// Находит значения ключей словаря, не разбирая сами значения
+std::vector<std::pair<std::string, std::string_view>> SplitDict(std::string_view text);
+
+// Читает поток целиком и разбирает его как один JSON-документ
 Document Load(std::istream& input);
 
+Document Load(std::string_view text);
+
+// Разбирает документ, читая поток порциями фиксированного размера, и сообщает о нём handler
+void Parse(std::istream& input, Handler& handler);
+
 void Print(const Document& doc, std::ostream& output);
 
 }  // namespace json
\ No newline at end of file
@@ -2,95 +2,90 @@
 
 namespace json {
 
+Builder::Builder(Builder&& other) {
+    TakeFrom(other);
+}
+
+Builder& Builder::operator=(Builder&& other) {
+    if (this != &other) {
+        TakeFrom(other);
+    }
+    return *this;
+}
+
 Builder::DictItemContext Builder::StartDict() {
-    AddContainerToStack<Dict>();
-    has_data_ = true;
+    AddContainer<Dict>();
     return DictItemContext{*this};
 }
 
 Builder::ValueItemContext Builder::EndDict() {
-    if (!nodes_stack_.empty() && !nodes_stack_.back()->IsMap()) {
+    if (nodes_stack_.empty() || !nodes_stack_.back()->IsMap() || has_key_) {
         throw std::logic_error("Failed to end dict");
     }
     nodes_stack_.pop_back();
     return ValueItemContext{*this};
 }
 
-Builder::KeyItemContext Builder::Key(std::string key) {
-    cur_key_ = std::move(key);
+Builder::KeyItemContext Builder::Key(std::string_view key) {
+    if (nodes_stack_.empty() || !nodes_stack_.back()->IsMap() || has_key_) {
+        throw std::logic_error("Key is allowed only inside a dict");
+    }
+    key_.assign(key);
+    has_key_ = true;
     return KeyItemContext{*this};
 }
 
-Builder::ValueItemContext Builder::Value(Node::Value value) {
-    if (!cur_key_) {
-        AddValue(Node{std::move(value)});
-    } else {
-        AddDictValue(std::move(value));
-    }
-    has_data_ = true;
+Builder::ValueItemContext Builder::Value(std::string_view value) {
+    AddValue(std::string(value));
     return ValueItemContext{*this};
 }
 
-Builder::ArrayItemContext Builder::StartArray() {
-    AddContainerToStack<Array>();
-    has_data_ = true;
+Builder::ArrayItemContext Builder::StartArray(size_t capacity) {
+    AddContainer<Array>()->AsArray().reserve(capacity);
     return ArrayItemContext{*this};
 }
 
 Builder::ValueItemContext Builder::EndArray() {
-    if (!nodes_stack_.empty() && !nodes_stack_.back()->IsArray()) {
+    if (nodes_stack_.empty() || !nodes_stack_.back()->IsArray()) {
         throw std::logic_error("Failed to end array");
     }
     nodes_stack_.pop_back();
     return ValueItemContext{*this};
 }
 
+// Стек и буфер ключа сохраняют выделенную память для следующего документа
 Node Builder::Build() {
     if (!nodes_stack_.empty() || !has_data_) {
         throw std::logic_error("Failed to build");
     }
+    has_data_ = false;
     return std::move(root_);
 }
 
 void Builder::CheckIfFinalized() const {
-    if (has_data_ && !root_.IsMap() && !root_.IsArray()) {
+    if (has_data_ && nodes_stack_.empty()) {
         throw std::logic_error("Failed to change finalized object");
     }
 }
 
-template <typename T>
-void Builder::AddContainerToStack() {
-    CheckIfFinalized();
-    if (root_.IsNull()) {
-        root_ = T{};
-        nodes_stack_.push_back(&root_);
-    } else {
-        Node* last_node = nodes_stack_.back();
-        if (last_node->IsMap() && cur_key_) {
-            auto key = cur_key_.value();
-            Value(T{});
-            nodes_stack_.push_back(&last_node->AsMap().at(key));
-        } else if (last_node->IsArray()) {
-            last_node->AsArray().emplace_back(T{});
-            nodes_stack_.push_back(&last_node->AsArray().back());
-        }
-    }
-}
-
-void Builder::AddValue(Node value) {
-    CheckIfFinalized();
-    if (root_.IsNull()) {
-        root_ = std::move(value);
-    } else if (Node* last_node = nodes_stack_.back(); 
-            last_node->IsArray()) {
-        last_node->AsArray().emplace_back(std::move(value));
+void Builder::TakeFrom(Builder& other) {
+    root_ = std::move(other.root_);
+    nodes_stack_ = std::move(other.nodes_stack_);
+    if (!nodes_stack_.empty() && nodes_stack_.front() == &other.root_) {
+        nodes_stack_.front() = &root_;
     }
+    key_ = std::move(other.key_);
+    has_key_ = std::exchange(other.has_key_, false);
+    has_data_ = std::exchange(other.has_data_, false);
+    other.root_ = Node{};
+    other.nodes_stack_.clear();
 }
 
-void Builder::AddDictValue(Node::Value value) {
-    Node* last_node = nodes_stack_.back();
-    last_node->AsMap().emplace(cur_key_.value(), std::move(value));
-    cur_key_ = std::nullopt;
+template <typename T>
+Node* Builder::AddContainer() {
+    Node* container = AddValue(T{});
+    nodes_stack_.push_back(container);
+    return container;
 }
 
 } // namespace json
\ No newline at end of file
@@ -2,10 +2,20 @@
 
 #include "json.h"
 
-#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 namespace json {
 
+// Строит json::Node. Значения создаются сразу на своём месте в дереве, ключ копируется
+// только в сам словарь. После Build построитель можно использовать заново,
+// внутренние буферы при этом сохраняются.
+// Арены у построителя нет: Dict и Array используют стандартный аллокатор, а построенный
+// json::Node передаётся остальному коду и живёт дольше построителя. Ответы на запросы
+// выводит json::Writer без построения дерева, поэтому ключи ответов память не выделяют
 class Builder {
     class ItemContext;
     class KeyItemContext;
@@ -15,15 +25,27 @@ class Builder {
 public:
     Builder() = default;
 
+    Builder(const Builder&) = delete;
+    Builder& operator=(const Builder&) = delete;
+
+    // Можно перемещать и посреди построения: стек переносится на корень нового построителя.
+    // Перемещённый построитель становится пустым
+    Builder(Builder&& other);
+    Builder& operator=(Builder&& other);
+
     DictItemContext StartDict();
 
     ValueItemContext EndDict();
 
-    KeyItemContext Key(std::string key);
+    KeyItemContext Key(std::string_view key);
+
+    template <typename T>
+    ValueItemContext Value(T&& value);
 
-    ValueItemContext Value(Node::Value value);
+    ValueItemContext Value(std::string_view value);
 
-    ArrayItemContext StartArray();
+    // capacity резервирует место под элементы массива
+    ArrayItemContext StartArray(size_t capacity = 0);
 
     ValueItemContext EndArray();
 
@@ -32,24 +54,26 @@ public:
 private:
     Node root_;
     std::vector<Node*> nodes_stack_;
-    std::optional<std::string> cur_key_;
+    std::string key_;
+    bool has_key_ = false;
     bool has_data_ = false;
 
     class ItemContext {
     public:
         Builder& builder;
 
-        ItemContext(Builder& bldr) 
+        ItemContext(Builder& bldr)
             : builder(bldr) {
         }
 
-        ItemContext& Key(std::string key) {
-            builder.Key(std::move(key));
+        ItemContext& Key(std::string_view key) {
+            builder.Key(key);
             return *this;
         }
 
-        ItemContext& Value(Node::Value value) {
-            builder.Value(std::move(value));
+        template <typename T>
+        ItemContext& Value(T&& value) {
+            builder.Value(std::forward<T>(value));
             return *this;
         }
 
@@ -58,8 +82,8 @@ private:
             return *this;
         }
 
-        ItemContext& StartArray() {
-            builder.StartArray();
+        ItemContext& StartArray(size_t capacity = 0) {
+            builder.StartArray(capacity);
             return *this;
         }
 
@@ -80,10 +104,11 @@ private:
 
     class KeyItemContext : public ItemContext {
     public:
-        ItemContext& Key(std::string key) = delete;
+        ItemContext& Key(std::string_view key) = delete;
 
-        DictItemContext Value(Node::Value value) {
-            builder.Value(std::move(value));
+        template <typename T>
+        DictItemContext Value(T&& value) {
+            builder.Value(std::forward<T>(value));
             return DictItemContext{*this};
         }
 
@@ -92,8 +117,8 @@ private:
             return DictItemContext{*this};
         }
 
-        ArrayItemContext StartArray() {
-            builder.StartArray();
+        ArrayItemContext StartArray(size_t capacity = 0) {
+            builder.StartArray(capacity);
             return ArrayItemContext{*this};
         }
 
@@ -104,10 +129,11 @@ private:
 
     class ValueItemContext : public ItemContext {
     public:
-        ItemContext& Key(std::string key) = delete;
-        ItemContext& Value(Node::Value value) = delete;
+        ItemContext& Key(std::string_view key) = delete;
+        template <typename T>
+        ItemContext& Value(T&& value) = delete;
         ItemContext& StartDict() = delete;
-        ItemContext& StartArray() = delete;
+        ItemContext& StartArray(size_t capacity = 0) = delete;
         ItemContext& EndDict() = delete;
         ItemContext& EndArray() = delete;
 
@@ -118,14 +144,15 @@ private:
 
     class DictItemContext : public ItemContext {
     public:
-        KeyItemContext Key(std::string key) {
-            builder.Key(std::move(key));
+        KeyItemContext Key(std::string_view key) {
+            builder.Key(key);
             return KeyItemContext{*this};
         }
 
-        ItemContext& Value(Node::Value value) = delete;
+        template <typename T>
+        ItemContext& Value(T&& value) = delete;
         ItemContext& StartDict() = delete;
-        ItemContext& StartArray() = delete;
+        ItemContext& StartArray(size_t capacity = 0) = delete;
 
         ItemContext& EndDict() {
             builder.EndDict();
@@ -138,10 +165,11 @@ private:
 
     class ArrayItemContext : public ItemContext {
     public:
-        ItemContext& Key(std::string key) = delete;
+        ItemContext& Key(std::string_view key) = delete;
 
-        ArrayItemContext Value(Node::Value value) {
-            builder.Value(std::move(value));
+        template <typename T>
+        ArrayItemContext Value(T&& value) {
+            builder.Value(std::forward<T>(value));
             return ArrayItemContext{*this};
         }
 
@@ -150,8 +178,8 @@ private:
             return DictItemContext{*this};
         }
 
-        ArrayItemContext StartArray() {
-            builder.StartArray();
+        ArrayItemContext StartArray(size_t capacity = 0) {
+            builder.StartArray(capacity);
             return *this;
         }
 
@@ -167,12 +195,43 @@ private:
 
     void CheckIfFinalized() const;
 
-    template <typename T>
-    void AddContainerToStack();
+    // Забирает состояние other. Остальные элементы стека указывают внутрь контейнеров,
+    // которые переезжают вместе с корнем, поэтому меняется только ссылка на сам корень
+    void TakeFrom(Builder& other);
 
-    void AddValue(Node value);
+    // Размещает значение в текущем контейнере и возвращает указатель на него
+    template <typename T>
+    Node* AddValue(T&& value);
 
-    void AddDictValue(Node::Value value);
+    template <typename T>
+    Node* AddContainer();
 };
 
+template <typename T>
+Builder::ValueItemContext Builder::Value(T&& value) {
+    AddValue(std::forward<T>(value));
+    return ValueItemContext{*this};
+}
+
+template <typename T>
+Node* Builder::AddValue(T&& value) {
+    using namespace std::literals;
+    CheckIfFinalized();
+    Node* result = nullptr;
+    if (nodes_stack_.empty()) {
+        root_ = Node(std::forward<T>(value));
+        result = &root_;
+    } else if (Node* last_node = nodes_stack_.back(); last_node->IsArray()) {
+        result = &last_node->AsArray().emplace_back(std::forward<T>(value));
+    } else {
+        if (!has_key_) {
+            throw std::logic_error("Value inside a dict must follow a key"s);
+        }
+        result = &last_node->AsMap().try_emplace(key_, std::forward<T>(value)).first->second;
+        has_key_ = false;
+    }
+    has_data_ = true;
+    return result;
+}
+
 } // namespace json
\ No newline at end of file
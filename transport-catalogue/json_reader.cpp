@@ -3,18 +3,86 @@
 #include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <deque>
+#include <future>
 #include <iostream>
 #include <iterator>
 #include <sstream>
+#include <type_traits>
 
 namespace transport_catalogue {
 
 namespace json_processing {
 
+namespace {
+
+// Число порций на поток: мелкие порции выравнивают нагрузку, если элементы разного размера
+constexpr size_t CHUNKS_PER_THREAD = 4;
+// Число запросов к базе в одной задаче пула
+constexpr size_t STAT_CHUNK_SIZE = 64;
+// Число порций запросов на поток, которые вычисляются раньше, чем будут выведены
+constexpr size_t IN_FLIGHT_CHUNKS_PER_THREAD = 2;
+
+// Делит элементы на непрерывные порции и разбирает их в потоках pool.
+// Результаты порций возвращаются в порядке следования элементов
+template <typename ParseChunk>
+auto ParseInChunks(const std::vector<std::string_view>& elements, ThreadPool& pool, ParseChunk parse_chunk) {
+    using Iterator = std::vector<std::string_view>::const_iterator;
+    using Result = std::invoke_result_t<ParseChunk, Iterator, Iterator>;
+    const size_t chunk_count = std::min(elements.size(), std::max<size_t>(pool.GetThreadCount(), 1) * CHUNKS_PER_THREAD);
+    std::vector<std::future<Result>> pending;
+    pending.reserve(chunk_count);
+    for (size_t i = 0; i < chunk_count; ++i) {
+        const Iterator begin = elements.begin() + elements.size() * i / chunk_count;
+        const Iterator end = elements.begin() + elements.size() * (i + 1) / chunk_count;
+        pending.push_back(pool.Submit([begin, end, &parse_chunk] {
+            return parse_chunk(begin, end);
+        }));
+    }
+    // Задачи ссылаются на elements, поэтому до выброса исключения нужно дождаться их всех
+    for (auto& chunk : pending) {
+        chunk.wait();
+    }
+    std::vector<Result> result;
+    result.reserve(chunk_count);
+    for (auto& chunk : pending) {
+        result.push_back(chunk.get());
+    }
+    return result;
+}
+
+// Записывает ответ элементом массива верхнего уровня и делит его на части до номера
+// запроса и после него
+std::shared_ptr<const SerializedResponse> SerializeResponse(Stat stat, json::Writer::Format format) {
+    using namespace std::literals;
+    stat.request_id = 0;
+    std::ostringstream output;
+    {
+        json::Writer writer(output, format);
+        writer.StartArray();
+        JsonPrinter::PrintStat(stat, writer);
+        writer.EndArray();
+    }
+    const std::string text = output.str();
+    const std::string_view key = format == json::Writer::Format::PRETTY ? "\"request_id\": "sv : "\"request_id\":"sv;
+    // Кавычки внутри строковых значений экранированы, поэтому найдётся именно ключ
+    const size_t begin = text.find('{');
+    const size_t value = text.find(key, begin) + key.size();
+    const size_t end = text.rfind('}') + 1;
+    return std::make_shared<const SerializedResponse>(SerializedResponse{
+        text.substr(begin, value - begin), text.substr(value + 1, end - value - 1)});
+}
+
+} // namespace
+
 void JsonReader::ParseInput(std::istream& input) {
-    using namespace json;
+    const std::string text = json::ReadAll(input);
+    ParseDocument(json::FlatDocument(text).GetRoot());
+}
+
+template <typename Node>
+void JsonReader::ParseDocument(const Node& requests) {
     using namespace std::literals;
-    Node requests = Load(input).GetRoot();
     for (const auto& [key, value] : requests.AsMap()) {
         if (key == "base_requests"s) {
             ParseBaseRequests(value);
@@ -28,24 +96,69 @@ void JsonReader::ParseInput(std::istream& input) {
     }
 }
 
+json::Dict JsonReader::ParseTextInParallel(std::string_view text, ThreadPool& pool) {
+    using namespace std::literals;
+    using Iterator = std::vector<std::string_view>::const_iterator;
+    json::Dict sections;
+    for (const auto& [key, value] : json::SplitDict(text)) {
+        if (key == "base_requests"s) {
+            auto chunks = ParseInChunks(json::SplitArray(value), pool, [](Iterator begin, Iterator end) {
+                BaseRequests requests;
+                json::FlatDocument document;
+                for (auto it = begin; it != end; ++it) {
+                    document.Parse(*it);
+                    ParseBaseRequest(document.GetRoot(), requests);
+                }
+                return requests;
+            });
+            for (auto& chunk : chunks) {
+                std::move(chunk.stops.begin(), chunk.stops.end(), std::back_inserter(base_requests_.stops));
+                std::move(chunk.buses.begin(), chunk.buses.end(), std::back_inserter(base_requests_.buses));
+            }
+        } else if (key == "stat_requests"s) {
+            auto chunks = ParseInChunks(json::SplitArray(value), pool, [](Iterator begin, Iterator end) {
+                std::vector<StatRequest> requests;
+                requests.reserve(end - begin);
+                json::FlatDocument document;
+                for (auto it = begin; it != end; ++it) {
+                    document.Parse(*it);
+                    requests.push_back(ParseStatRequest(document.GetRoot()));
+                }
+                return requests;
+            });
+            for (auto& chunk : chunks) {
+                std::move(chunk.begin(), chunk.end(), std::back_inserter(stat_requests_));
+            }
+        } else {
+            sections.emplace(key, json::Load(value).GetRoot());
+        }
+    }
+    return sections;
+}
+
 void JsonReader::FillBase(TransportCatalogue& catalogue) const {
-    if (!base_stop_requests_.empty()) {
-        for (const auto& stop : base_stop_requests_) {
+    if (!base_requests_.stops.empty()) {
+        for (const auto& stop : base_requests_.stops) {
             catalogue.AddStop(Stop{stop.name, 
                 geo::Coordinates{stop.latitude, stop.longitude}});
         }
-        for (const auto& stop : base_stop_requests_) {
+        for (const auto& stop : base_requests_.stops) {
             if (stop.road_distances) {
                 catalogue.AddMapOfDistances(stop.name, stop.road_distances.value());
             }
         }
     }
-    if (!base_bus_requests_.empty()) {
-        for (const auto& bus : base_bus_requests_) {
+    if (!base_requests_.buses.empty()) {
+        for (const auto& bus : base_requests_.buses) {
             catalogue.AddBus(Bus{bus.name, 
                 MakeVectorOfStops(bus.stops, bus.is_roundtrip, catalogue), bus.is_roundtrip});
         }
     }
+    catalogue.BuildIndexes();
+}
+
+bool JsonReader::HasBaseRequests() const {
+    return !base_requests_.stops.empty() || !base_requests_.buses.empty();
 }
 
 const std::vector<StatRequest>& JsonReader::GetStatRequests() const {
@@ -60,15 +173,17 @@ TransportRouteProcessor::RoutingSettings JsonReader::GetRoutingSettings() const
     return routing_settings_;
 }
 
-DistanceInfo JsonReader::ParseDistances(const json::Node& data) {
+template <typename Node>
+DistanceInfo JsonReader::ParseDistances(const Node& data) {
     DistanceInfo distances;
     for (const auto& [key, value] : data.AsMap()) {
-        distances.insert({key, value.AsInt()});
+        distances.emplace(key, value.AsInt());
     }
     return distances;
 }
 
-void JsonReader::ParseStopRequest(const json::Node& data) {
+template <typename Node>
+BaseStopRequest JsonReader::ParseStopRequest(const Node& data) {
     using namespace std::literals;
     BaseStopRequest request;
     for (const auto& [key, value] : data.AsMap()) {
@@ -79,25 +194,28 @@ void JsonReader::ParseStopRequest(const json::Node& data) {
         } else if (key == "longitude"s) {
             request.longitude = value.AsDouble();
         } else if (key == "road_distances"s) {
-            if (value == nullptr) {
+            if (value.IsNull()) {
                 request.road_distances = std::nullopt;
             } else {
                 request.road_distances = std::move(ParseDistances(value));
             }
         }
     }
-    base_stop_requests_.push_back(std::move(request));
+    return request;
 }
 
-std::vector<std::string> JsonReader::ParseStops(const json::Node& data) {
+template <typename Node>
+std::vector<std::string> JsonReader::ParseStops(const Node& data) {
     std::vector<std::string> stops;
+    stops.reserve(data.AsArray().size());
     for (const auto& elem : data.AsArray()) {
-        stops.push_back(elem.AsString());
+        stops.emplace_back(elem.AsString());
     }
     return stops;
 }
 
-void JsonReader::ParseBusRequest(const json::Node& data) {
+template <typename Node>
+BaseBusRequest JsonReader::ParseBusRequest(const Node& data) {
     using namespace std::literals;
     BaseBusRequest request;
     for (const auto& [key, value] : data.AsMap()) {
@@ -109,29 +227,32 @@ void JsonReader::ParseBusRequest(const json::Node& data) {
             request.is_roundtrip = value.AsBool();
         }
     }
-    base_bus_requests_.push_back(std::move(request));
+    return request;
 }
 
-void JsonReader::ParseBaseRequest(const json::Node& request) {
+template <typename Node>
+void JsonReader::ParseBaseRequest(const Node& request, BaseRequests& requests) {
     using namespace std::literals;
     for (const auto& [key, value] : request.AsMap()) {
         if (key == "type"s) {
             if (value.AsString() == "Stop"s) {
-                ParseStopRequest(request); 
+                requests.stops.push_back(ParseStopRequest(request));
             } else if (value.AsString() == "Bus"s) {
-                ParseBusRequest(request); 
+                requests.buses.push_back(ParseBusRequest(request));
             }
         }
     }
 }
 
-void JsonReader::ParseBaseRequests(const json::Node& base_requests) {
+template <typename Node>
+void JsonReader::ParseBaseRequests(const Node& base_requests) {
     for (const auto& request : base_requests.AsArray()) {
-        ParseBaseRequest(request);
+        ParseBaseRequest(request, base_requests_);
     } 
 }
 
-void JsonReader::ParseStatRequest(const json::Node& request_data) {
+template <typename Node>
+StatRequest JsonReader::ParseStatRequest(const Node& request_data) {
     using namespace std::literals;
     StatRequest request;
     for (const auto& [key, value] : request_data.AsMap()) {
@@ -139,20 +260,47 @@ void JsonReader::ParseStatRequest(const json::Node& request_data) {
             request.id = value.AsInt();
         } else if (key == "type"s) {
             request.type = value.AsString();
+        } else if (key == "city"s) {
+            request.city = value.AsString();
         } else if (key == "name"s) {
             request.name = value.AsString();
         } else if (key == "from"s) {
             request.from = value.AsString(); 
         } else if (key == "to"s) {
             request.to = value.AsString();
+        } else if (key == "prefix"s) {
+            request.prefix = value.AsString();
+        } else if (key == "latitude"s) {
+            request.point.lat = value.AsDouble();
+        } else if (key == "longitude"s) {
+            request.point.lng = value.AsDouble();
+        } else if (key == "count"s) {
+            request.count = value.AsInt();
+        } else if (key == "min_latitude"s) {
+            request.area.min.lat = value.AsDouble();
+        } else if (key == "min_longitude"s) {
+            request.area.min.lng = value.AsDouble();
+        } else if (key == "max_latitude"s) {
+            request.area.max.lat = value.AsDouble();
+        } else if (key == "max_longitude"s) {
+            request.area.max.lng = value.AsDouble();
+        } else if (key == "zoom"s) {
+            request.zoom = value.AsInt();
+        } else if (key == "x"s) {
+            request.x = value.AsInt();
+        } else if (key == "y"s) {
+            request.y = value.AsInt();
+        } else if (key == "format"s) {
+            request.format = value.AsString();
         }
     }
-    stat_requests_.push_back(std::move(request));
+    return request;
 }
 
-void JsonReader::ParseStatRequests(const json::Node& stat_requests) {
+template <typename Node>
+void JsonReader::ParseStatRequests(const Node& stat_requests) {
     for (const auto& request : stat_requests.AsArray()) {
-        ParseStatRequest(request);
+        stat_requests_.push_back(ParseStatRequest(request));
     } 
 }
 
@@ -171,30 +319,32 @@ std::vector<const Stop*> JsonReader::MakeVectorOfStops(const std::vector<std::st
     return busroute;
 }
 
-svg::Color GetColor(const json::Node& color) {
+template <typename Node>
+svg::Color GetColor(const Node& color) {
     svg::Color result;
     if (color.IsArray()) {
         if (color.AsArray().size() == 4) {
-            auto array = color.AsArray();
+            const auto& array = color.AsArray();
             svg::Rgba rgba{static_cast<uint8_t>(array.at(0).AsInt()), 
                 static_cast<uint8_t>(array.at(1).AsInt()), 
                 static_cast<uint8_t>(array.at(2).AsInt()), 
                 array.at(3).AsDouble()};
             result = rgba;
         } else if (color.AsArray().size() == 3) {
-            auto array = color.AsArray();
+            const auto& array = color.AsArray();
             svg::Rgb rgb{static_cast<uint8_t>(array.at(0).AsInt()), 
                 static_cast<uint8_t>(array.at(1).AsInt()), 
                 static_cast<uint8_t>(array.at(2).AsInt())};
             result = rgb;
         }
     } else if (color.IsString()) {
-        result = color.AsString();
+        result = std::string(color.AsString());
     }
     return result;
 }
 
-void JsonReader::ParseRenderSettings(const json::Node& render_settings) {
+template <typename Node>
+void JsonReader::ParseRenderSettings(const Node& render_settings) {
     using namespace renderer;
     using namespace std::literals;
     for (const auto& [key, value] : render_settings.AsMap()) {
@@ -226,11 +376,18 @@ void JsonReader::ParseRenderSettings(const json::Node& render_settings) {
             for (const auto& elem : value.AsArray()) {
                 render_settings_.color_palette.push_back(GetColor(elem));
             }
+        } else if (key == "simplification_tolerance"s) {
+            render_settings_.simplification_tolerance = value.AsDouble();
+        } else if (key == "compact_svg"s) {
+            render_settings_.compact_svg = value.AsBool();
+        } else if (key == "path_precision"s) {
+            render_settings_.path_precision = value.AsInt();
         }
     }
 }
 
-void JsonReader::ParseRoutingSettings(const json::Node& routing_settings) {
+template <typename Node>
+void JsonReader::ParseRoutingSettings(const Node& routing_settings) {
     using namespace std::literals;
     for (const auto& [key, value] : routing_settings.AsMap()) {
         if (key == "bus_wait_time"s) {
@@ -241,16 +398,64 @@ void JsonReader::ParseRoutingSettings(const json::Node& routing_settings) {
     }
 }
 
-JsonPrinter::JsonPrinter(RequestHandler& request_handler, 
-    const std::vector<StatRequest>& stat_requests) 
-    : request_handler_(&request_handler), stats_(MakeStats(stat_requests)) {
+template void JsonReader::ParseDocument<json::Node>(const json::Node& requests);
+template void JsonReader::ParseDocument<json::FlatNode>(const json::FlatNode& requests);
+
+StatProcessor::StatProcessor(RequestHandler& request_handler, ResponseCache* cache, json::Writer::Format format) 
+    : request_handler_(&request_handler), cache_(cache), format_(format) {
+}
+
+std::optional<Stat> StatProcessor::Process(const StatRequest& request) {
+    using namespace std::literals;
+    if (request.type == "Stop"s) {
+        return ProcessCached(request, ResponseCache::Kind::STOP, &StatProcessor::ProcessStopRequest);
+    } else if (request.type == "Bus"s) {
+        return ProcessCached(request, ResponseCache::Kind::BUS, &StatProcessor::ProcessBusRequest);
+    } else if (request.type == "Map"s) {
+        return ProcessMapRequest(request);
+    } else if (request.type == "Route"s) {
+        return ProcessRouteRequest(request);
+    } else if (request.type == "NearestStops"s) {
+        return ProcessNearestStopsRequest(request);
+    } else if (request.type == "StopsInArea"s) {
+        return ProcessStopsInAreaRequest(request);
+    } else if (request.type == "StopSearch"s) {
+        return ProcessStopSearchRequest(request);
+    } else if (request.type == "MapTile"s) {
+        return ProcessMapTileRequest(request);
+    } else if (request.type == "MapData"s) {
+        return ProcessMapDataRequest(request);
+    }
+    return std::nullopt;
 }
 
-void JsonPrinter::PrintStats(std::ostream& output) {
-    json::Print(MakeJson(), output);
+// Ответы «not found» не кэшируются, чтобы запросы с произвольными названиями не занимали кэш
+Stat StatProcessor::ProcessCached(const StatRequest& request, ResponseCache::Kind kind,
+        Stat (StatProcessor::*process)(const StatRequest&)) {
+    if (cache_ == nullptr) {
+        return (this->*process)(request);
+    }
+    if (auto response = cache_->Find(kind, format_, request.name)) {
+        return Stat{request.id, CachedResponse{std::move(response)}};
+    }
+    Stat stat = (this->*process)(request);
+    const bool is_found = std::visit([](const auto& data) {
+        if constexpr (std::is_same_v<std::decay_t<decltype(data)>, StopData>
+                || std::is_same_v<std::decay_t<decltype(data)>, BusData>) {
+            return data.has_value();
+        } else {
+            return false;
+        }
+    }, stat.data);
+    if (!is_found) {
+        return stat;
+    }
+    auto response = SerializeResponse(std::move(stat), format_);
+    cache_->Insert(kind, format_, request.name, response);
+    return Stat{request.id, CachedResponse{std::move(response)}};
 }
 
-Stat JsonPrinter::ProcessStopRequest(const StatRequest& request) {
+Stat StatProcessor::ProcessStopRequest(const StatRequest& request) {
     StopData data;
     const auto* buses = request_handler_->GetBusesByStop(request.name);
     if (buses == nullptr) {
@@ -266,7 +471,7 @@ Stat JsonPrinter::ProcessStopRequest(const StatRequest& request) {
     return Stat{request.id, data};
 }
 
-Stat JsonPrinter::ProcessBusRequest(const StatRequest& request) {
+Stat StatProcessor::ProcessBusRequest(const StatRequest& request) {
     BusData data;
     auto bus_info = request_handler_->GetBusInfo(request.name);
     if (!bus_info) {
@@ -281,12 +486,11 @@ Stat JsonPrinter::ProcessBusRequest(const StatRequest& request) {
     return Stat{request.id, data};
 }
 
-Stat JsonPrinter::ProcessMapRequest(const StatRequest& request) {
-    const auto* data = request_handler_->RenderMap();
-    return Stat{request.id, data};
+Stat StatProcessor::ProcessMapRequest(const StatRequest& request) {
+    return Stat{request.id, MapData{request_handler_->RenderMap()}};
 }
 
-Stat JsonPrinter::ProcessRouteRequest(const StatRequest& request) {
+Stat StatProcessor::ProcessRouteRequest(const StatRequest& request) {
     const auto route_info = request_handler_->GetRoute(request.from, request.to);
     if (!route_info) {
         return Stat{request.id, RouteData{}};
@@ -294,89 +498,261 @@ Stat JsonPrinter::ProcessRouteRequest(const StatRequest& request) {
     return Stat{request.id, route_info};
 }
 
-std::vector<Stat> JsonPrinter::MakeStats(const std::vector<StatRequest>& stat_requests) {
+Stat StatProcessor::ProcessNearestStopsRequest(const StatRequest& request) {
+    size_t count = request.count > 0 ? static_cast<size_t>(request.count) : 0;
+    return Stat{request.id, request_handler_->GetNearestStops(request.point, count)};
+}
+
+Stat StatProcessor::ProcessStopsInAreaRequest(const StatRequest& request) {
+    return Stat{request.id, request_handler_->GetStopsInArea(request.area)};
+}
+
+Stat StatProcessor::ProcessStopSearchRequest(const StatRequest& request) {
+    size_t count = request.count > 0 ? static_cast<size_t>(request.count) : 0;
+    return Stat{request.id, request_handler_->SearchStops(request.prefix, count)};
+}
+
+Stat StatProcessor::ProcessMapTileRequest(const StatRequest& request) {
     using namespace std::literals;
-    std::vector<Stat> result;
-    for (const auto& request : stat_requests) {
-        if (request.type == "Stop"s) {
-            result.push_back(ProcessStopRequest(request));
-        } else if (request.type == "Bus"s) {
-            result.push_back(ProcessBusRequest(request));
-        } else if (request.type == "Map"s) {
-            result.push_back(ProcessMapRequest(request));
-        } else if (request.type == "Route"s) {
-            result.push_back(ProcessRouteRequest(request));
-        }
+    auto tile = request_handler_->RenderTile(renderer::TileRequest{request.zoom, request.x, request.y, request.area});
+    if (!tile) {
+        return Stat{request.id, StatError{"invalid tile"s}};
     }
-    return result;
+    return Stat{request.id, MapData{std::move(tile)}};
 }
 
-json::Document JsonPrinter::MakeJson() {
+Stat StatProcessor::ProcessMapDataRequest(const StatRequest& request) {
     using namespace std::literals;
-    json::Builder builder;
-    builder.StartArray();
-    for (const auto& stat : stats_) {
-        builder.StartDict()
-        .Key("request_id"s).Value(stat.request_id);
-        if (std::holds_alternative<StopData>(stat.data)) {
-            StopData data = std::get<StopData>(stat.data);
-            if (!data) {
-                builder.Key("error_message"s).Value("not found"s);
-            } else {
-                builder.Key("buses"s)
-                .StartArray();
-                for (const auto& bus : data.value()) {
-                    builder.Value(bus);
+    if (request.format.empty() || request.format == "json"s) {
+        return Stat{request.id, MapGeometryData{request_handler_->GetMapGeometry(), nullptr}};
+    } else if (request.format == "binary"s) {
+        return Stat{request.id, MapGeometryData{nullptr, request_handler_->GetEncodedMapGeometry()}};
+    }
+    return Stat{request.id, StatError{"unknown format"s}};
+}
+
+JsonPrinter::JsonPrinter(RequestHandler& request_handler, 
+    const std::vector<StatRequest>& stat_requests, ThreadPool* pool, ResponseCache* cache) 
+    : request_handler_(&request_handler), stat_requests_(&stat_requests), pool_(pool), cache_(cache) {
+}
+
+JsonPrinter::JsonPrinter(std::vector<Stat> stats) 
+    : stats_(std::move(stats)) {
+}
+
+void JsonPrinter::PrintStats(std::ostream& output, json::Writer::Format format) {
+    json::Writer writer(output, format);
+    writer.StartArray();
+    if (request_handler_ != nullptr && pool_ != nullptr) {
+        PrintStatsInParallel(writer);
+    } else if (request_handler_ != nullptr) {
+        StatProcessor processor(*request_handler_, cache_, format);
+        for (const auto& request : *stat_requests_) {
+            if (auto stat = processor.Process(request)) {
+                PrintStat(*stat, writer);
+            }
+        }
+    } else {
+        for (const auto& stat : stats_) {
+            PrintStat(stat, writer);
+        }
+    }
+    writer.EndArray();
+}
+
+// Запросы делятся на порции по STAT_CHUNK_SIZE. Порции выводятся по порядку, как только будут
+// готовы. Одновременно вычисляются не больше IN_FLIGHT_CHUNKS_PER_THREAD порций на поток,
+// поэтому потоки не обгоняют медленный вывод и память не растёт с размером пакета
+void JsonPrinter::PrintStatsInParallel(json::Writer& writer) {
+    using Chunk = std::vector<std::optional<Stat>>;
+    const auto& requests = *stat_requests_;
+    const size_t chunk_count = (requests.size() + STAT_CHUNK_SIZE - 1) / STAT_CHUNK_SIZE;
+    const size_t max_in_flight = std::max<size_t>(pool_->GetThreadCount(), 1) * IN_FLIGHT_CHUNKS_PER_THREAD;
+    std::deque<std::future<Chunk>> pending;
+    size_t submitted = 0;
+    const json::Writer::Format format = writer.GetFormat();
+    auto submit_next = [this, &requests, &pending, &submitted, format] {
+        const size_t begin = submitted++ * STAT_CHUNK_SIZE;
+        const size_t end = std::min(begin + STAT_CHUNK_SIZE, requests.size());
+        pending.push_back(pool_->Submit([this, begin, end, &requests, format] {
+            StatProcessor processor(*request_handler_, cache_, format);
+            Chunk stats;
+            stats.reserve(end - begin);
+            for (size_t i = begin; i < end; ++i) {
+                stats.push_back(processor.Process(requests[i]));
+            }
+            return stats;
+        }));
+    };
+    try {
+        while (submitted < chunk_count && pending.size() < max_in_flight) {
+            submit_next();
+        }
+        while (!pending.empty()) {
+            Chunk stats = pending.front().get();
+            pending.pop_front();
+            // Следующая порция вычисляется, пока выводится эта
+            if (submitted < chunk_count) {
+                submit_next();
+            }
+            for (const auto& stat : stats) {
+                if (stat) {
+                    PrintStat(*stat, writer);
                 }
-                builder.EndArray();
             }
-        } else if (std::holds_alternative<BusData>(stat.data)) {
-            BusData data = std::get<BusData>(stat.data);
-            if (!data) {
-                builder.Key("error_message"s).Value("not found"s);
-            } else {
-                builder.Key("stop_count"s).Value(int(data.value().stops))
-                .Key("unique_stop_count"s).Value(int(data.value().unique_stops))
-                .Key("route_length"s).Value(data.value().route_length)
-                .Key("curvature"s).Value(data.value().curvature);
+        }
+    } catch (...) {
+        // Задачи ссылаются на requests, поэтому до выхода нужно дождаться их всех
+        for (auto& chunk : pending) {
+            chunk.wait();
+        }
+        throw;
+    }
+}
+
+void JsonPrinter::PrintStat(const Stat& stat, json::Writer& writer) {
+    using namespace std::literals;
+    // Записанный ответ уже содержит свои скобки
+    if (const auto* cached = std::get_if<CachedResponse>(&stat.data)) {
+        writer.RawValue(cached->response->before, stat.request_id, cached->response->after);
+        return;
+    }
+    writer.StartDict();
+    if (std::holds_alternative<StopData>(stat.data)) {
+        const StopData& data = std::get<StopData>(stat.data);
+        if (!data) {
+            writer.Key("error_message"sv).Value("not found"sv);
+        } else {
+            writer.Key("buses"sv).StartArray();
+            for (const auto& bus : data.value()) {
+                writer.Value(bus);
             }
-        } else if (std::holds_alternative<const svg::Document*>(stat.data)) {
-            const auto* data = std::get<const svg::Document*>(stat.data);
-            std::ostringstream s;
-            data->Render(s);
-            builder.Key("map"s).Value(s.str());
-        } else if (std::holds_alternative<RouteData>(stat.data)) {
-            RouteData data = std::get<RouteData>(stat.data);
-            if (!data) {
-                builder.Key("error_message"s).Value("not found"s);
-            } else {
-                builder.Key("total_time"s).Value(data.value().total_time)
-                .Key("items"s).StartArray();
-                for (const auto& item : data.value().items) {
-                    if (std::holds_alternative<WaitItem>(item)) {
-                        WaitItem wait_item = std::get<WaitItem>(item);
-                        builder.StartDict()
-                        .Key("type"s).Value("Wait"s)
-                        .Key("stop_name"s).Value(std::move(wait_item.stopname))
-                        .Key("time"s).Value(wait_item.time)
-                        .EndDict();
-                    } else {
-                        BusItem bus_item = std::get<BusItem>(item);
-                        builder.StartDict()
-                        .Key("type"s).Value("Bus"s)
-                        .Key("bus"s).Value(std::move(bus_item.busname))
-                        .Key("span_count"s).Value(bus_item.span_count)
-                        .Key("time"s).Value(bus_item.time)
-                        .EndDict();
-                    }
+            writer.EndArray();
+        }
+        writer.Key("request_id"sv).Value(stat.request_id);
+    } else if (std::holds_alternative<BusData>(stat.data)) {
+        const BusData& data = std::get<BusData>(stat.data);
+        if (!data) {
+            writer.Key("error_message"sv).Value("not found"sv)
+            .Key("request_id"sv).Value(stat.request_id);
+        } else {
+            writer.Key("curvature"sv).Value(data.value().curvature)
+            .Key("request_id"sv).Value(stat.request_id)
+            .Key("route_length"sv).Value(data.value().route_length)
+            .Key("stop_count"sv).Value(static_cast<int>(data.value().stops))
+            .Key("unique_stop_count"sv).Value(static_cast<int>(data.value().unique_stops));
+        }
+    } else if (std::holds_alternative<MapData>(stat.data)) {
+        writer.Key("map"sv).EscapedValue(*std::get<MapData>(stat.data).escaped_svg)
+        .Key("request_id"sv).Value(stat.request_id);
+    } else if (std::holds_alternative<RouteData>(stat.data)) {
+        const RouteData& data = std::get<RouteData>(stat.data);
+        if (!data) {
+            writer.Key("error_message"sv).Value("not found"sv)
+            .Key("request_id"sv).Value(stat.request_id);
+        } else {
+            writer.Key("items"sv).StartArray();
+            for (const auto& item : data.value().items) {
+                writer.StartDict();
+                if (std::holds_alternative<WaitItem>(item)) {
+                    const WaitItem& wait_item = std::get<WaitItem>(item);
+                    writer.Key("stop_name"sv).Value(wait_item.stopname)
+                    .Key("time"sv).Value(wait_item.time)
+                    .Key("type"sv).Value("Wait"sv);
+                } else {
+                    const BusItem& bus_item = std::get<BusItem>(item);
+                    writer.Key("bus"sv).Value(bus_item.busname)
+                    .Key("span_count"sv).Value(bus_item.span_count)
+                    .Key("time"sv).Value(bus_item.time)
+                    .Key("type"sv).Value("Bus"sv);
                 }
-                builder.EndArray();
+                writer.EndDict();
+            }
+            writer.EndArray()
+            .Key("request_id"sv).Value(stat.request_id)
+            .Key("total_time"sv).Value(data.value().total_time);
+        }
+    } else if (std::holds_alternative<NearestStopsData>(stat.data)) {
+        writer.Key("request_id"sv).Value(stat.request_id)
+        .Key("stops"sv).StartArray();
+        for (const auto& [stop, distance] : std::get<NearestStopsData>(stat.data)) {
+            writer.StartDict()
+            .Key("distance"sv).Value(distance)
+            .Key("name"sv).Value(stop->stopname)
+            .EndDict();
+        }
+        writer.EndArray();
+    } else if (std::holds_alternative<AreaData>(stat.data)) {
+        const AreaData& data = std::get<AreaData>(stat.data);
+        writer.Key("buses"sv).StartArray();
+        for (const auto& bus : data.buses) {
+            writer.Value(bus);
+        }
+        writer.EndArray()
+        .Key("request_id"sv).Value(stat.request_id)
+        .Key("stops"sv).StartArray();
+        for (const auto& stop : data.stops) {
+            writer.Value(stop);
+        }
+        writer.EndArray();
+    } else if (std::holds_alternative<StopSearchData>(stat.data)) {
+        writer.Key("request_id"sv).Value(stat.request_id)
+        .Key("stops"sv).StartArray();
+        for (const auto& stop : std::get<StopSearchData>(stat.data)) {
+            writer.Value(stop);
+        }
+        writer.EndArray();
+    } else if (std::holds_alternative<ShardUsageData>(stat.data)) {
+        writer.Key("request_id"sv).Value(stat.request_id)
+        .Key("shards"sv).StartArray();
+        for (const auto& usage : std::get<ShardUsageData>(stat.data)) {
+            writer.StartDict()
+            .Key("build_cpu_ms"sv).Value(usage.build_cpu_ms)
+            .Key("city"sv).Value(usage.city)
+            .Key("memory_kb"sv).Value(static_cast<int>(usage.memory_bytes / 1024))
+            .Key("query_cpu_ms"sv).Value(usage.query_cpu_ms)
+            .Key("requests"sv).Value(static_cast<int>(usage.requests))
+            .EndDict();
+        }
+        writer.EndArray();
+    } else if (std::holds_alternative<MapGeometryData>(stat.data)) {
+        const MapGeometryData& data = std::get<MapGeometryData>(stat.data);
+        if (data.encoded) {
+            // В алфавите base64 нет символов, которые нужно экранировать
+            writer.Key("data"sv).EscapedValue(*data.encoded)
+            .Key("format"sv).Value("binary"sv)
+            .Key("request_id"sv).Value(stat.request_id);
+        } else {
+            writer.Key("buses"sv).StartArray();
+            for (const auto& route : data.geometry->routes) {
+                writer.StartDict()
+                .Key("name"sv).Value(route.name)
+                .Key("palette_index"sv).Value(static_cast<int>(route.palette_index))
+                .Key("stops"sv).StartArray();
+                for (uint32_t stop_id : route.stop_ids) {
+                    writer.Value(static_cast<int>(stop_id));
+                }
+                writer.EndArray()
+                .EndDict();
+            }
+            writer.EndArray()
+            .Key("request_id"sv).Value(stat.request_id)
+            .Key("stops"sv).StartArray();
+            for (const auto& stop : data.geometry->stops) {
+                writer.StartDict()
+                .Key("id"sv).Value(static_cast<int>(stop.id))
+                .Key("name"sv).Value(stop.name)
+                .Key("x"sv).Value(stop.point.x)
+                .Key("y"sv).Value(stop.point.y)
+                .EndDict();
             }
+            writer.EndArray();
         }
-        builder.EndDict();
+    } else if (std::holds_alternative<StatError>(stat.data)) {
+        writer.Key("error_message"sv).Value(std::get<StatError>(stat.data).message)
+        .Key("request_id"sv).Value(stat.request_id);
     }
-    builder.EndArray();
-    return json::Document(builder.Build());
+    writer.EndDict();
 }
 
 } // namespace json_processing
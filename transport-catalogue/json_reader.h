@@ -1,12 +1,16 @@
 #pragma once
 
+#include <memory>
 #include <string>
 #include <string_view>
 #include <vector>
 
 #include "json_builder.h"
+#include "json_writer.h"
 #include "map_renderer.h"
 #include "request_handler.h"
+#include "response_cache.h"
+#include "thread_pool.h"
 #include "transport_catalogue.h"
 
 namespace transport_catalogue {
@@ -28,20 +32,44 @@ struct BaseBusRequest {
     bool is_roundtrip;
 };
 
+struct BaseRequests {
+    std::vector<BaseStopRequest> stops;
+    std::vector<BaseBusRequest> buses;
+};
+
 struct StatRequest {
     int id;
     std::string type;
+    std::string city;
     std::string name;
     std::string from;
     std::string to;
+    std::string prefix;
+    geo::Coordinates point{0.0, 0.0};
+    int count = 0;
+    geo::Area area{{0.0, 0.0}, {0.0, 0.0}};
+    std::optional<int> zoom;
+    int x = 0;
+    int y = 0;
+    std::string format;
 };
 
 class JsonReader {
 public:
     void ParseInput(std::istream& input);
 
+    // Принимает как json::Node, так и узел компактного документа json::FlatNode
+    template <typename Node>
+    void ParseDocument(const Node& requests);
+
+    // Разбирает документ, целиком находящийся в памяти. Элементы base_requests и stat_requests
+    // разбираются порциями в потоках pool. Возвращает остальные разделы документа
+    json::Dict ParseTextInParallel(std::string_view text, ThreadPool& pool);
+
     void FillBase(TransportCatalogue& catalogue) const;
 
+    bool HasBaseRequests() const;
+
     const std::vector<StatRequest>& GetStatRequests() const;
     
     const renderer::RenderSettings& GetRenderSettings() const;
@@ -49,55 +77,97 @@ public:
     TransportRouteProcessor::RoutingSettings GetRoutingSettings() const;
 
 private:
-    std::vector<BaseStopRequest> base_stop_requests_;
-    std::vector<BaseBusRequest> base_bus_requests_;
+    BaseRequests base_requests_;
     std::vector<StatRequest> stat_requests_;
     renderer::RenderSettings render_settings_;
     TransportRouteProcessor::RoutingSettings routing_settings_;
 
-    static DistanceInfo ParseDistances(const json::Node& data);
+    template <typename Node>
+    static DistanceInfo ParseDistances(const Node& data);
 
-    void ParseStopRequest(const json::Node& data);
+    template <typename Node>
+    static BaseStopRequest ParseStopRequest(const Node& data);
 
-    static std::vector<std::string> ParseStops(const json::Node& data);
+    template <typename Node>
+    static std::vector<std::string> ParseStops(const Node& data);
 
-    void ParseBusRequest(const json::Node& data);
+    template <typename Node>
+    static BaseBusRequest ParseBusRequest(const Node& data);
 
-    void ParseBaseRequest(const json::Node& request);
+    template <typename Node>
+    static void ParseBaseRequest(const Node& request, BaseRequests& requests);
 
-    void ParseBaseRequests(const json::Node& base_requests);
+    template <typename Node>
+    void ParseBaseRequests(const Node& base_requests);
 
-    void ParseStatRequest(const json::Node& request_data);
+    template <typename Node>
+    static StatRequest ParseStatRequest(const Node& request_data);
 
-    void ParseStatRequests(const json::Node& stat_requests);
+    template <typename Node>
+    void ParseStatRequests(const Node& stat_requests);
 
     static std::vector<const Stop*> MakeVectorOfStops(const std::vector<std::string>& stops, 
         bool is_roundtrip, const TransportCatalogue& catalogue);
 
-    void ParseRenderSettings(const json::Node& render_settings);
+    template <typename Node>
+    void ParseRenderSettings(const Node& render_settings);
 
-    void ParseRoutingSettings(const json::Node& routing_settings);
+    template <typename Node>
+    void ParseRoutingSettings(const Node& routing_settings);
 };
 
 using StopData = std::optional<std::vector<std::string>>;
 using BusData = std::optional<BusInfo>;
 using RouteData = std::optional<RouteInfo>;
+using NearestStopsData = std::vector<StopDistance>;
+using AreaData = AreaInfo;
+using StopSearchData = std::vector<std::string>;
+using ShardUsageData = std::vector<ShardUsage>;
+
+struct MapData {
+    // Текст SVG, экранированный для строки JSON
+    std::shared_ptr<const std::string> escaped_svg;
+};
+
+struct MapGeometryData {
+    std::shared_ptr<const renderer::MapGeometry> geometry;
+    // Двоичная геометрия в base64, если запрошен формат binary. Тогда geometry не задана
+    std::shared_ptr<const std::string> encoded;
+};
+
+// Ответ, взятый из ResponseCache. Записан в формате вывода JsonPrinter
+struct CachedResponse {
+    std::shared_ptr<const SerializedResponse> response;
+};
+
+struct StatError {
+    std::string message;
+};
 
 struct Stat {
     int request_id;
-    std::variant<StopData, BusData, const svg::Document*, RouteData> data;
+    std::variant<StopData, BusData, MapData, RouteData, NearestStopsData, AreaData,
+        StopSearchData, ShardUsageData, MapGeometryData, CachedResponse, StatError> data;
 };
 
-class JsonPrinter {
+class StatProcessor {
 public:
-    explicit JsonPrinter(RequestHandler& request_handler, 
-        const std::vector<StatRequest>& stat_requests);
+    // Если задан cache, ответы на запросы Bus и Stop берутся из него и добавляются в него
+    // записанными в формате format
+    explicit StatProcessor(RequestHandler& request_handler, ResponseCache* cache = nullptr,
+        json::Writer::Format format = json::Writer::Format::PRETTY);
 
-    void PrintStats(std::ostream& output);
+    // Возвращает std::nullopt для запросов неизвестного типа
+    std::optional<Stat> Process(const StatRequest& request);
 
 private:
     RequestHandler* request_handler_;
-    std::vector<Stat> stats_;
+    ResponseCache* cache_;
+    json::Writer::Format format_;
+
+    // Берёт ответ из кэша либо вычисляет его через process и, если он найден, записывает в кэш
+    Stat ProcessCached(const StatRequest& request, ResponseCache::Kind kind,
+        Stat (StatProcessor::*process)(const StatRequest&));
 
     Stat ProcessStopRequest(const StatRequest& request);
 
@@ -107,9 +177,40 @@ private:
 
     Stat ProcessRouteRequest(const StatRequest& request);
 
-    std::vector<Stat> MakeStats(const std::vector<StatRequest>& stat_requests);
+    Stat ProcessNearestStopsRequest(const StatRequest& request);
+
+    Stat ProcessStopsInAreaRequest(const StatRequest& request);
+
+    Stat ProcessStopSearchRequest(const StatRequest& request);
+
+    Stat ProcessMapTileRequest(const StatRequest& request);
+
+    Stat ProcessMapDataRequest(const StatRequest& request);
+};
+
+class JsonPrinter {
+public:
+    // Ответы на запросы формируются и выводятся по одному во время PrintStats.
+    // Если задан pool, запросы выполняются в его потоках. cache должен принадлежать
+    // той же версии справочника, что и request_handler
+    explicit JsonPrinter(RequestHandler& request_handler, 
+        const std::vector<StatRequest>& stat_requests, ThreadPool* pool = nullptr, ResponseCache* cache = nullptr);
+
+    explicit JsonPrinter(std::vector<Stat> stats);
+
+    void PrintStats(std::ostream& output, json::Writer::Format format = json::Writer::Format::PRETTY);
+
+    // Ключи выводятся по возрастанию, как в словарях json::Node
+    static void PrintStat(const Stat& stat, json::Writer& writer);
+
+private:
+    RequestHandler* request_handler_ = nullptr;
+    const std::vector<StatRequest>* stat_requests_ = nullptr;
+    ThreadPool* pool_ = nullptr;
+    ResponseCache* cache_ = nullptr;
+    std::vector<Stat> stats_;
 
-    json::Document MakeJson();
+    void PrintStatsInParallel(json::Writer& writer);
 };
 
 } // namespace json_processing
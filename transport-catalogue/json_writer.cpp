@@ -0,0 +1,230 @@
+#include "json_writer.h"
+
+#include <array>
+#include <charconv>
+#include <stdexcept>
+
+namespace json {
+
+namespace {
+
+constexpr size_t BUFFER_SIZE = 1 << 16;
+constexpr size_t INDENT_STEP = 4;
+// Столько же значащих цифр выводит std::ostream по умолчанию
+constexpr int DOUBLE_PRECISION = 6;
+
+// Экранируемые символы и их замены. Для остальных символов замена пустая
+constexpr std::array<std::string_view, 256> MakeEscapes() {
+    std::array<std::string_view, 256> escapes{};
+    escapes['\n'] = "\\n";
+    escapes['\t'] = "\\t";
+    escapes['\r'] = "\\r";
+    escapes['"'] = "\\\"";
+    escapes['\\'] = "\\\\";
+    return escapes;
+}
+
+constexpr std::array<std::string_view, 256> ESCAPES = MakeEscapes();
+
+} // namespace
+
+void AppendEscaped(std::string& out, std::string_view value) {
+    size_t plain_begin = 0;
+    for (size_t i = 0; i < value.size(); ++i) {
+        const std::string_view escaped = ESCAPES[static_cast<unsigned char>(value[i])];
+        if (escaped.empty()) {
+            continue;
+        }
+        out.append(value, plain_begin, i - plain_begin);
+        out += escaped;
+        plain_begin = i + 1;
+    }
+    out.append(value, plain_begin, value.size() - plain_begin);
+}
+
+Writer::Writer(std::ostream& output, Format format)
+    : output_(output), format_(format) {
+    buffer_.reserve(BUFFER_SIZE);
+}
+
+Writer::~Writer() {
+    Flush();
+}
+
+Writer& Writer::StartDict() {
+    StartContainer('{', true);
+    return *this;
+}
+
+Writer& Writer::EndDict() {
+    EndContainer('}', true);
+    return *this;
+}
+
+Writer& Writer::StartArray() {
+    StartContainer('[', false);
+    return *this;
+}
+
+Writer& Writer::EndArray() {
+    EndContainer(']', false);
+    return *this;
+}
+
+Writer& Writer::Key(std::string_view key) {
+    using namespace std::literals;
+    if (levels_.empty() || !levels_.back().is_dict || after_key_) {
+        throw std::logic_error("Key is allowed only inside a dict"s);
+    }
+    WriteSeparator();
+    buffer_ += '"';
+    AppendEscaped(buffer_, key);
+    buffer_ += '"';
+    buffer_ += format_ == Format::PRETTY ? ": "sv : ":"sv;
+    after_key_ = true;
+    return *this;
+}
+
+Writer& Writer::Value(std::nullptr_t) {
+    using namespace std::literals;
+    StartValue();
+    buffer_ += "null"sv;
+    FlushIfFull();
+    return *this;
+}
+
+Writer& Writer::Value(bool value) {
+    using namespace std::literals;
+    StartValue();
+    buffer_ += value ? "true"sv : "false"sv;
+    FlushIfFull();
+    return *this;
+}
+
+Writer& Writer::Value(int value) {
+    StartValue();
+    char chars[16];
+    const auto result = std::to_chars(chars, chars + sizeof(chars), value);
+    buffer_.append(chars, result.ptr);
+    FlushIfFull();
+    return *this;
+}
+
+Writer& Writer::Value(double value) {
+    StartValue();
+    char chars[32];
+    const auto result = std::to_chars(chars, chars + sizeof(chars), value, std::chars_format::general, DOUBLE_PRECISION);
+    buffer_.append(chars, result.ptr);
+    FlushIfFull();
+    return *this;
+}
+
+Writer& Writer::Value(std::string_view value) {
+    StartValue();
+    buffer_ += '"';
+    AppendEscaped(buffer_, value);
+    buffer_ += '"';
+    FlushIfFull();
+    return *this;
+}
+
+Writer& Writer::Value(const char* value) {
+    return Value(std::string_view(value));
+}
+
+// Длинные строки передаются в поток напрямую, минуя буфер
+Writer& Writer::EscapedValue(std::string_view escaped) {
+    StartValue();
+    buffer_ += '"';
+    if (escaped.size() >= BUFFER_SIZE) {
+        Flush();
+        output_.write(escaped.data(), static_cast<std::streamsize>(escaped.size()));
+    } else {
+        buffer_ += escaped;
+    }
+    buffer_ += '"';
+    FlushIfFull();
+    return *this;
+}
+
+Writer& Writer::RawValue(std::string_view before, int value, std::string_view after) {
+    StartValue();
+    buffer_ += before;
+    char chars[16];
+    const auto result = std::to_chars(chars, chars + sizeof(chars), value);
+    buffer_.append(chars, result.ptr);
+    buffer_ += after;
+    FlushIfFull();
+    return *this;
+}
+
+Writer::Format Writer::GetFormat() const {
+    return format_;
+}
+
+void Writer::Flush() {
+    output_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    buffer_.clear();
+}
+
+void Writer::StartValue() {
+    using namespace std::literals;
+    if (after_key_) {
+        after_key_ = false;
+        return;
+    }
+    if (!levels_.empty() && levels_.back().is_dict) {
+        throw std::logic_error("Value inside a dict must follow a key"s);
+    }
+    WriteSeparator();
+}
+
+// Пишет разделитель и отступ перед очередным элементом массива или ключом словаря
+void Writer::WriteSeparator() {
+    using namespace std::literals;
+    if (levels_.empty()) {
+        return;
+    }
+    if (!levels_.back().is_empty) {
+        buffer_ += format_ == Format::PRETTY ? ",\n"sv : ","sv;
+    }
+    levels_.back().is_empty = false;
+    WriteIndent(levels_.size());
+}
+
+void Writer::StartContainer(char bracket, bool is_dict) {
+    StartValue();
+    buffer_ += bracket;
+    if (format_ == Format::PRETTY) {
+        buffer_ += '\n';
+    }
+    levels_.push_back(Level{is_dict});
+}
+
+void Writer::EndContainer(char bracket, bool is_dict) {
+    using namespace std::literals;
+    if (levels_.empty() || levels_.back().is_dict != is_dict || after_key_) {
+        throw std::logic_error("Unexpected end of container"s);
+    }
+    levels_.pop_back();
+    if (format_ == Format::PRETTY) {
+        buffer_ += '\n';
+        WriteIndent(levels_.size());
+    }
+    buffer_ += bracket;
+    FlushIfFull();
+}
+
+void Writer::WriteIndent(size_t depth) {
+    if (format_ == Format::PRETTY) {
+        buffer_.append(depth * INDENT_STEP, ' ');
+    }
+}
+
+void Writer::FlushIfFull() {
+    if (buffer_.size() >= BUFFER_SIZE) {
+        Flush();
+    }
+}
+
+} // namespace json
\ No newline at end of file
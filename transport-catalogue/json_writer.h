@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace json {
+
+// Пишет JSON в поток по мере поступления значений, не строя документ в памяти.
+// Вывод в режиме PRETTY совпадает с json::Print, если ключи словарей идут по возрастанию
+class Writer {
+public:
+    enum class Format {
+        PRETTY,
+        COMPACT
+    };
+
+    explicit Writer(std::ostream& output, Format format = Format::PRETTY);
+
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+
+    ~Writer();
+
+    Writer& StartDict();
+
+    Writer& EndDict();
+
+    Writer& StartArray();
+
+    Writer& EndArray();
+
+    Writer& Key(std::string_view key);
+
+    Writer& Value(std::nullptr_t);
+
+    Writer& Value(bool value);
+
+    Writer& Value(int value);
+
+    Writer& Value(double value);
+
+    Writer& Value(std::string_view value);
+
+    Writer& Value(const char* value);
+
+    // Выводит строку, заранее экранированную через AppendEscaped
+    Writer& EscapedValue(std::string_view escaped);
+
+    // Выводит значение, заранее записанное в том же формате на той же глубине,
+    // вставляя число value между before и after
+    Writer& RawValue(std::string_view before, int value, std::string_view after);
+
+    Format GetFormat() const;
+
+    // Передаёт накопленный вывод в поток
+    void Flush();
+
+private:
+    struct Level {
+        bool is_dict;
+        bool is_empty = true;
+    };
+
+    std::ostream& output_;
+    Format format_;
+    std::string buffer_;
+    std::vector<Level> levels_;
+    bool after_key_ = false;
+
+    void StartValue();
+
+    void WriteSeparator();
+
+    void StartContainer(char bracket, bool is_dict);
+
+    void EndContainer(char bracket, bool is_dict);
+
+    void WriteIndent(size_t depth);
+
+    void FlushIfFull();
+};
+
+// Дописывает value в out так, как оно выглядит внутри строки JSON, без кавычек.
+// Отрезки без специальных символов копируются целиком
+void AppendEscaped(std::string& out, std::string_view value);
+
+} // namespace json
\ No newline at end of file
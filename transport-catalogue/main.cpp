@@ -1,19 +1,48 @@
+#include "city_shards.h"
+#include "hot_reload.h"
 #include "json_reader.h"
 #include "map_renderer.h"
+#include "query_server.h"
 #include "request_handler.h"
+#include "stream_reader.h"
+#include "thread_pool.h"
+#include "versioned_catalogue.h"
 
 #include <fstream>
 #include <iostream>
+#include <string_view>
 
-int main() {
+int main(int argc, char* argv[]) {
     using namespace transport_catalogue;
-    json_processing::JsonReader reader;
+    using namespace std::literals;
+    if (argc == 3 && argv[1] == "--watch"sv) {
+        return ServeWithHotReload(argv[2], std::cin, std::cout);
+    }
+    if (argc == 4 && argv[1] == "--check-map-reuse"sv) {
+        return CheckMapReuse(argv[2], argv[3], std::cout);
+    }
+    if ((argc == 3 || (argc == 5 && argv[3] == "--socket"sv)) && argv[1] == "--serve"sv) {
+        return ServeQueries(argv[2], argc == 5 ? argv[4] : "", std::cin, std::cout);
+    }
     TransportCatalogue catalogue;
-    reader.ParseInput(std::cin);
-    reader.FillBase(catalogue);
-    renderer::MapRenderer renderer(reader.GetRenderSettings(), catalogue.GetAllCoordinates());
-    TransportRouteProcessor route_processor(reader.GetRoutingSettings(), catalogue);
-    RequestHandler handler{catalogue, renderer, route_processor};
-    json_processing::JsonPrinter printer{handler, reader.GetStatRequests()};
+    json_processing::JsonReader reader;
+    json::Dict sections;
+    ThreadPool pool;
+    if (argc == 2 && argv[1] == "--parallel"sv) {
+        sections = reader.ParseTextInParallel(json::ReadAll(std::cin), pool);
+        reader.FillBase(catalogue);
+    } else {
+        sections = json_processing::StreamingReader(catalogue).Read(std::cin);
+    }
+    const json::Node document(std::move(sections));
+    reader.ParseDocument(document);
+    if (document.AsMap().count("cities"s) > 0) {
+        ServeCities(document.AsMap().at("cities"s), reader.GetStatRequests(), std::cout);
+        return 0;
+    }
+    VersionedCatalogue versions(std::move(catalogue), reader.GetRoutingSettings(), reader.GetRenderSettings());
+    auto snapshot = versions.Acquire();
+    RequestHandler handler{snapshot->catalogue, snapshot->renderer, snapshot->router, &pool};
+    json_processing::JsonPrinter printer{handler, reader.GetStatRequests(), &pool, &snapshot->responses};
     printer.PrintStats(std::cout);
 }
\ No newline at end of file
@@ -0,0 +1,89 @@
+#include "map_geometry.h"
+
+#include <cstring>
+
+namespace transport_catalogue {
+
+namespace renderer {
+
+namespace {
+
+void AppendUint32(std::string& out, uint32_t value) {
+    for (int shift = 0; shift < 32; shift += 8) {
+        out += static_cast<char>((value >> shift) & 0xFF);
+    }
+}
+
+void AppendDouble(std::string& out, double value) {
+    uint64_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+    for (int shift = 0; shift < 64; shift += 8) {
+        out += static_cast<char>((bits >> shift) & 0xFF);
+    }
+}
+
+void AppendString(std::string& out, std::string_view value) {
+    AppendUint32(out, static_cast<uint32_t>(value.size()));
+    out += value;
+}
+
+} // namespace
+
+std::string EncodeMapGeometry(const MapGeometry& geometry) {
+    size_t size = 2 * sizeof(uint32_t);
+    for (const auto& route : geometry.routes) {
+        size += 3 * sizeof(uint32_t) + route.name.size() + route.stop_ids.size() * sizeof(uint32_t);
+    }
+    for (const auto& stop : geometry.stops) {
+        size += 2 * sizeof(uint32_t) + stop.name.size() + 2 * sizeof(double);
+    }
+    std::string result;
+    result.reserve(size);
+    AppendUint32(result, static_cast<uint32_t>(geometry.routes.size()));
+    for (const auto& route : geometry.routes) {
+        AppendString(result, route.name);
+        AppendUint32(result, route.palette_index);
+        AppendUint32(result, static_cast<uint32_t>(route.stop_ids.size()));
+        for (uint32_t stop_id : route.stop_ids) {
+            AppendUint32(result, stop_id);
+        }
+    }
+    AppendUint32(result, static_cast<uint32_t>(geometry.stops.size()));
+    for (const auto& stop : geometry.stops) {
+        AppendUint32(result, stop.id);
+        AppendString(result, stop.name);
+        AppendDouble(result, stop.point.x);
+        AppendDouble(result, stop.point.y);
+    }
+    return result;
+}
+
+std::string EncodeBase64(std::string_view data) {
+    static constexpr char ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string result;
+    result.reserve((data.size() + 2) / 3 * 4);
+    size_t i = 0;
+    for (; i + 3 <= data.size(); i += 3) {
+        const uint32_t triple = static_cast<uint8_t>(data[i]) << 16 | static_cast<uint8_t>(data[i + 1]) << 8
+            | static_cast<uint8_t>(data[i + 2]);
+        result += ALPHABET[triple >> 18];
+        result += ALPHABET[(triple >> 12) & 0x3F];
+        result += ALPHABET[(triple >> 6) & 0x3F];
+        result += ALPHABET[triple & 0x3F];
+    }
+    if (const size_t rest = data.size() - i; rest > 0) {
+        uint32_t triple = static_cast<uint8_t>(data[i]) << 16;
+        if (rest == 2) {
+            triple |= static_cast<uint8_t>(data[i + 1]) << 8;
+        }
+        result += ALPHABET[triple >> 18];
+        result += ALPHABET[(triple >> 12) & 0x3F];
+        result += rest == 2 ? ALPHABET[(triple >> 6) & 0x3F] : '=';
+        result += '=';
+    }
+    return result;
+}
+
+} // namespace renderer
+
+} // namespace transport_catalogue
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "svg.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace transport_catalogue {
+
+namespace renderer {
+
+// Геометрия карты без SVG: маршруты в порядке вывода на карту и точки остановок
+// в координатах полной карты
+struct MapGeometry {
+    struct Route {
+        std::string name;
+        // Номер цвета маршрута в color_palette
+        uint32_t palette_index = 0;
+        // Stop::id остановок маршрута по порядку, для некольцевых маршрутов вместе с обратным ходом
+        std::vector<uint32_t> stop_ids;
+    };
+
+    struct StopPoint {
+        uint32_t id = 0;
+        std::string name;
+        svg::Point point;
+    };
+
+    std::vector<Route> routes;
+    std::vector<StopPoint> stops;
+};
+
+/*
+ * Двоичное представление геометрии. Целые числа — uint32 в порядке little-endian,
+ * координаты — double в порядке little-endian, строки — длина uint32 и байты:
+ *   число маршрутов, для каждого: название, palette_index, число остановок, их id
+ *   число остановок, для каждой: id, название, x, y
+ */
+std::string EncodeMapGeometry(const MapGeometry& geometry);
+
+std::string EncodeBase64(std::string_view data);
+
+} // namespace renderer
+
+} // namespace transport_catalogue
\ No newline at end of file
@@ -1,114 +1,489 @@
 #include "map_renderer.h"
 
+#include "json_writer.h"
+
+#include <charconv>
+#include <cmath>
+#include <limits>
+
 namespace transport_catalogue {
 
 namespace renderer {
 
-MapRenderer::MapRenderer(const RenderSettings& settings, const std::vector<geo::Coordinates>& coords) 
-    : settings_(settings), proj_(SetProjector(coords)) {
+namespace {
+
+constexpr size_t TILE_CACHE_SIZE = 256;
+// Длина подписи в размерах шрифта, на которую подпись может заходить на плитку снаружи
+constexpr double LABEL_MARGIN_EM = 8.0;
+// Части документа мельче, чем по одной на поток, чтобы длинные ломаные не задерживали остальные
+constexpr size_t PARTS_PER_THREAD = 4;
+
+void AppendNumber(std::string& out, double value) {
+    char chars[32];
+    const auto result = std::to_chars(chars, chars + sizeof(chars), value);
+    out.append(chars, result.ptr);
+}
+
+bool IsSameArea(const geo::Area& lhs, const geo::Area& rhs) {
+    return lhs.min == rhs.min && lhs.max == rhs.max;
+}
+
+std::string MakeTileKey(const TileRequest& request) {
+    std::string key;
+    if (request.zoom) {
+        key = std::to_string(*request.zoom) + '/' + std::to_string(request.x) + '/' + std::to_string(request.y);
+    } else {
+        for (double value : {request.area.min.lat, request.area.min.lng, request.area.max.lat, request.area.max.lng}) {
+            key += ':';
+            AppendNumber(key, value);
+        }
+    }
+    return key;
+}
+
+} // namespace
+
+bool operator==(const RenderSettings& lhs, const RenderSettings& rhs) {
+    return lhs.width == rhs.width && lhs.height == rhs.height && lhs.padding == rhs.padding
+        && lhs.line_width == rhs.line_width && lhs.stop_radius == rhs.stop_radius
+        && lhs.bus_label_font_size == rhs.bus_label_font_size && lhs.bus_label_offset == rhs.bus_label_offset
+        && lhs.stop_label_font_size == rhs.stop_label_font_size && lhs.stop_label_offset == rhs.stop_label_offset
+        && lhs.underlayer_color == rhs.underlayer_color && lhs.underlayer_width == rhs.underlayer_width
+        && lhs.color_palette == rhs.color_palette && lhs.font_family == rhs.font_family
+        && lhs.font_weight == rhs.font_weight && lhs.simplification_tolerance == rhs.simplification_tolerance
+        && lhs.compact_svg == rhs.compact_svg && lhs.path_precision == rhs.path_precision;
 }
 
-const svg::Document* MapRenderer::RenderRoutes(const std::deque<Bus>& buses, const std::deque<Stop>& stops) {
-    size_t i = 0;
+MapRenderer::MapRenderer(const RenderSettings& settings, const StopCoordinates& coords) 
+    : settings_(settings), bounds_(FindBounds(coords)),
+    proj_(bounds_, settings_.width, settings_.height, settings_.padding), map_(MakeDocument()) {
+    ProjectStops(coords);
+}
+
+std::shared_ptr<const std::string> MapRenderer::GetMap(const TransportCatalogue& catalogue, ThreadPool* pool) {
+    std::call_once(map_rendered_, [&] {
+        // Упрощённая карта совпадает с плиткой нулевого уровня
+        if (settings_.simplification_tolerance > 0.0) {
+            const auto viewport = MakeViewport(TileRequest{0}, settings_.width, settings_.height, proj_);
+            map_json_ = std::make_shared<const std::string>(RenderTile(GetTileIndex(catalogue), *viewport));
+            return;
+        }
+        std::shared_ptr<const MapFragments> previous;
+        {
+            std::lock_guard guard(fragments_mutex_);
+            previous = std::move(fragments_);
+        }
+        // При сдвиге границ меняются координаты всех элементов. В режиме классов номера
+        // классов зависят от всего документа, поэтому фрагменты тоже не переносятся
+        if (previous != nullptr && (!IsSameArea(previous->bounds, bounds_) || settings_.compact_svg)) {
+            previous.reset();
+        }
+        auto fragments = std::make_shared<MapFragments>();
+        fragments->bounds = bounds_;
+        map_json_ = std::make_shared<const std::string>(RenderFragments(catalogue.GetAllBuses(),
+            catalogue.GetAllStopsInRoutes(), previous.get(), *fragments, pool));
+        // Элементы документа больше не нужны
+        map_.Clear();
+        std::lock_guard guard(fragments_mutex_);
+        fragments_ = std::move(fragments);
+    });
+    return map_json_;
+}
+
+bool MapRenderer::BusFragment::IsSameRoute(const BusFragment& other) const {
+    return palette_index == other.palette_index && is_roundtrip == other.is_roundtrip && stop_ids == other.stop_ids
+        && points == other.points;
+}
+
+void MapRenderer::ReuseFragments(const MapRenderer& previous) {
+    std::shared_ptr<const MapFragments> fragments;
+    {
+        std::lock_guard guard(previous.fragments_mutex_);
+        fragments = previous.fragments_;
+    }
+    std::lock_guard guard(fragments_mutex_);
+    fragments_ = std::move(fragments);
+}
+
+std::shared_ptr<const std::string> MapRenderer::GetTile(const TransportCatalogue& catalogue, const TileRequest& request) {
+    const auto viewport = MakeViewport(request, settings_.width, settings_.height, proj_);
+    if (!viewport) {
+        return nullptr;
+    }
+    const std::string key = MakeTileKey(request);
+    {
+        std::lock_guard guard(tiles_mutex_);
+        if (auto it = tile_positions_.find(key); it != tile_positions_.end()) {
+            recent_tiles_.splice(recent_tiles_.begin(), recent_tiles_, it->second);
+            return it->second->second;
+        }
+    }
+    // Плитка отрисовывается без блокировки, одновременные запросы одной плитки допустимы
+    auto tile = std::make_shared<const std::string>(RenderTile(GetTileIndex(catalogue), *viewport));
+    std::lock_guard guard(tiles_mutex_);
+    if (tile_positions_.count(key) == 0) {
+        recent_tiles_.emplace_front(key, tile);
+        tile_positions_.emplace(key, recent_tiles_.begin());
+        if (recent_tiles_.size() > TILE_CACHE_SIZE) {
+            tile_positions_.erase(recent_tiles_.back().first);
+            recent_tiles_.pop_back();
+        }
+    }
+    return tile;
+}
+
+// Порядок маршрутов и номера цветов те же, что и на карте
+std::shared_ptr<const MapGeometry> MapRenderer::GetGeometry(const TransportCatalogue& catalogue) {
+    std::call_once(geometry_built_, [&] {
+        auto geometry = std::make_shared<MapGeometry>();
+        const size_t palette_size = std::max<size_t>(settings_.color_palette.size(), 1);
+        size_t color_index = 0;
+        for (const auto& bus : catalogue.GetAllBuses()) {
+            if (bus.busroute.empty()) {
+                continue;
+            }
+            auto& route = geometry->routes.emplace_back();
+            route.name = bus.busname;
+            route.palette_index = static_cast<uint32_t>(color_index++ % palette_size);
+            route.stop_ids.reserve(bus.busroute.size());
+            for (const Stop* stop : bus.busroute) {
+                route.stop_ids.push_back(static_cast<uint32_t>(stop->id));
+            }
+        }
+        for (const auto& stop : catalogue.GetAllStopsInRoutes()) {
+            geometry->stops.push_back({static_cast<uint32_t>(stop.id), stop.stopname, stop_points_[stop.id]});
+        }
+        geometry_ = std::move(geometry);
+    });
+    return geometry_;
+}
+
+std::shared_ptr<const std::string> MapRenderer::GetEncodedGeometry(const TransportCatalogue& catalogue) {
+    std::call_once(geometry_encoded_, [&] {
+        encoded_geometry_ = std::make_shared<const std::string>(EncodeBase64(EncodeMapGeometry(*GetGeometry(catalogue))));
+    });
+    return encoded_geometry_;
+}
+
+// Слои выводятся по очереди для всех маршрутов и остановок, в том же порядке
+// добавляются стили, поэтому номера классов совпадают с полной отрисовкой
+std::string MapRenderer::RenderFragments(const std::deque<Bus>& buses, const std::deque<Stop>& stops,
+        const MapFragments* previous, MapFragments& fragments, ThreadPool* pool) {
+    std::vector<BusFragment*> bus_order;
+    std::vector<bool> is_bus_reused;
+    size_t color_index = 0;
     for (const auto& bus : buses) {
         if (bus.busroute.empty()) {
             continue;
         }
-        svg::Color color = settings_.color_palette[i % settings_.color_palette.size()];
-        AddRoute(bus, color);
-        ++i;
+        BusFragment& fragment = fragments.buses[bus.busname];
+        fragment.palette_index = color_index++ % settings_.color_palette.size();
+        fragment.is_roundtrip = bus.is_roundtrip;
+        fragment.stop_ids.reserve(bus.busroute.size());
+        fragment.points.reserve(bus.busroute.size());
+        for (const Stop* stop : bus.busroute) {
+            fragment.stop_ids.push_back(stop->id);
+            fragment.points.push_back(stop_points_[stop->id]);
+        }
+        bool is_reused = false;
+        if (previous != nullptr) {
+            const auto it = previous->buses.find(bus.busname);
+            if (it != previous->buses.end() && it->second.IsSameRoute(fragment)) {
+                fragment.route = it->second.route;
+                fragment.labels = it->second.labels;
+                is_reused = true;
+            }
+        }
+        bus_order.push_back(&fragment);
+        is_bus_reused.push_back(is_reused);
     }
-    i = 0;
-    for (const auto& bus : buses) {
-        if (bus.busroute.empty()) {
+
+    std::vector<PendingFragment> pending;
+    auto add_pending = [this, &pending](std::string& out, size_t begin) {
+        pending.push_back(PendingFragment{&out, begin, map_.GetElementCount()});
+    };
+    for (size_t i = 0, bus_index = 0; i < buses.size(); ++i) {
+        if (buses[i].busroute.empty()) {
             continue;
         }
-        svg::Color color = settings_.color_palette[i % settings_.color_palette.size()];
-        AddBusnames(bus, color);
-        ++i;
+        BusFragment& fragment = *bus_order[bus_index];
+        if (!is_bus_reused[bus_index++]) {
+            const size_t begin = map_.GetElementCount();
+            AddRoute(buses[i], settings_.color_palette[fragment.palette_index]);
+            add_pending(fragment.route, begin);
+        }
     }
-    for (const auto& stop : stops) {
-        AddStop(stop);
+    for (size_t i = 0, bus_index = 0; i < buses.size(); ++i) {
+        if (buses[i].busroute.empty()) {
+            continue;
+        }
+        BusFragment& fragment = *bus_order[bus_index];
+        if (!is_bus_reused[bus_index++]) {
+            const size_t begin = map_.GetElementCount();
+            AddBusnames(buses[i], settings_.color_palette[fragment.palette_index]);
+            add_pending(fragment.labels, begin);
+        }
     }
+
+    std::vector<StopFragment*> stop_order;
+    std::vector<const Stop*> changed_stops;
     for (const auto& stop : stops) {
-        AddStopname(stop);
+        StopFragment& fragment = fragments.stops[stop.stopname];
+        fragment.point = stop_points_[stop.id];
+        stop_order.push_back(&fragment);
+        if (previous != nullptr) {
+            const auto it = previous->stops.find(stop.stopname);
+            if (it != previous->stops.end() && it->second.point == fragment.point) {
+                fragment.circle = it->second.circle;
+                fragment.label = it->second.label;
+                continue;
+            }
+        }
+        changed_stops.push_back(&stop);
+    }
+    const auto circle = map_.AddStyle(svg::Style{svg::Color{"white"}});
+    for (const Stop* stop : changed_stops) {
+        const size_t begin = map_.GetElementCount();
+        map_.AddCircle(stop_points_[stop->id], settings_.stop_radius, circle);
+        add_pending(fragments.stops.at(stop->stopname).circle, begin);
     }
-    return &map_;
+    const auto underlayer = map_.AddStyle(MakeUnderlayerStyle());
+    const auto label = map_.AddStyle(svg::Style{svg::Color{"black"}});
+    const auto font = map_.AddFont(settings_.font_family, {});
+    for (const Stop* stop : changed_stops) {
+        const size_t begin = map_.GetElementCount();
+        AddStopname(*stop, underlayer, label, font);
+        add_pending(fragments.stops.at(stop->stopname).label, begin);
+    }
+
+    RenderPending(pending, pool);
+
+    std::string header;
+    map_.RenderHeader(header);
+    std::string footer;
+    svg::BatchDocument::RenderFooter(footer);
+    size_t size = header.size() + footer.size();
+    for (const BusFragment* fragment : bus_order) {
+        size += fragment->route.size() + fragment->labels.size();
+    }
+    for (const StopFragment* fragment : stop_order) {
+        size += fragment->circle.size() + fragment->label.size();
+    }
+    std::string result;
+    result.reserve(size);
+    json::AppendEscaped(result, header);
+    for (const BusFragment* fragment : bus_order) {
+        result += fragment->route;
+    }
+    for (const BusFragment* fragment : bus_order) {
+        result += fragment->labels;
+    }
+    for (const StopFragment* fragment : stop_order) {
+        result += fragment->circle;
+    }
+    for (const StopFragment* fragment : stop_order) {
+        result += fragment->label;
+    }
+    json::AppendEscaped(result, footer);
+    return result;
 }
 
-SphereProjector MapRenderer::SetProjector(const std::vector<geo::Coordinates>& coords) {
-    return SphereProjector{coords.begin(), coords.end(), 
-        settings_.width, settings_.height, settings_.padding};
+// Фрагменты выводятся и экранируются независимо друг от друга, поэтому их можно
+// распределить по потокам пула
+void MapRenderer::RenderPending(const std::vector<PendingFragment>& pending, ThreadPool* pool) const {
+    auto render = [this, &pending](size_t begin, size_t end) {
+        std::string svg;
+        for (size_t i = begin; i < end; ++i) {
+            svg.clear();
+            map_.RenderElements(pending[i].begin, pending[i].end, svg);
+            json::AppendEscaped(*pending[i].out, svg);
+        }
+    };
+    if (pool == nullptr) {
+        render(0, pending.size());
+        return;
+    }
+    const size_t part_count = std::min(pool->GetThreadCount() * PARTS_PER_THREAD, pending.size());
+    pool->ParallelFor(part_count, [&render, &pending, part_count](size_t part) {
+        render(pending.size() * part / part_count, pending.size() * (part + 1) / part_count);
+    });
+}
+// Границы ищутся одним проходом сразу по широтам и долготам
+geo::Area MapRenderer::FindBounds(const StopCoordinates& coords) {
+    const size_t count = coords.lats.size();
+    const double* lats = coords.lats.data();
+    const double* lngs = coords.lngs.data();
+    const uint8_t* in_routes = coords.in_routes.data();
+    double min_lat = std::numeric_limits<double>::infinity();
+    double max_lat = -min_lat;
+    double min_lng = min_lat;
+    double max_lng = -min_lat;
+    for (size_t i = 0; i < count; ++i) {
+        // Остановки вне маршрутов получают пустой интервал и не сдвигают границ
+        const double low = in_routes[i] ? 0.0 : std::numeric_limits<double>::infinity();
+        min_lat = std::min(min_lat, lats[i] + low);
+        max_lat = std::max(max_lat, lats[i] - low);
+        min_lng = std::min(min_lng, lngs[i] + low);
+        max_lng = std::max(max_lng, lngs[i] - low);
+    }
+    geo::Area bounds{};
+    if (min_lat <= max_lat) {
+        bounds = {{min_lat, min_lng}, {max_lat, max_lng}};
+    }
+    return bounds;
 }
 
-void MapRenderer::AddRoute(const Bus& bus, const svg::Color& color) {
-    using namespace svg;
-    Polyline route;
-    route.SetFillColor("none").SetStrokeColor(color).SetStrokeWidth(settings_.line_width);
-    route.SetStrokeLineCap(StrokeLineCap::ROUND).SetStrokeLineJoin(StrokeLineJoin::ROUND);
-    for (const Stop* stop : bus.busroute) {
-        route.AddPoint(proj_(stop->coordinates));
+void MapRenderer::ProjectStops(const StopCoordinates& coords) {
+    const size_t count = coords.lats.size();
+    stop_points_.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        stop_points_[i] = proj_({coords.lats[i], coords.lngs[i]});
     }
-    map_.Add(std::move(route));
 }
 
-svg::Text MapRenderer::RenderBusname(const std::string& busname, const Stop& stop, const svg::Color& color) const {
-    svg::Text result;
-    result.SetPosition(proj_(stop.coordinates)).SetOffset(settings_.bus_label_offset);
-    result.SetFontSize(settings_.bus_label_font_size).SetFontFamily(settings_.font_family);
-    result.SetFontWeight(settings_.font_weight).SetData(busname).SetFillColor(color);
-    return result;
+svg::Style MapRenderer::MakeRouteStyle(const svg::Color& color) const {
+    return svg::Style{svg::Color{"none"}, color, settings_.line_width,
+        svg::StrokeLineCap::ROUND, svg::StrokeLineJoin::ROUND};
 }
 
-svg::Text MapRenderer::RenderBusnameUnderlayer(const std::string& busname, const Stop& stop) const {
-    using namespace svg;
-    Text result = RenderBusname(busname, stop);
-    result.SetFillColor(settings_.underlayer_color).SetStrokeColor(settings_.underlayer_color);
-    result.SetStrokeWidth(settings_.underlayer_width);
-    result.SetStrokeLineCap(StrokeLineCap::ROUND).SetStrokeLineJoin(StrokeLineJoin::ROUND);
-    return result;
+svg::Style MapRenderer::MakeUnderlayerStyle() const {
+    return svg::Style{settings_.underlayer_color, settings_.underlayer_color, settings_.underlayer_width,
+        svg::StrokeLineCap::ROUND, svg::StrokeLineJoin::ROUND};
+}
+
+void MapRenderer::AddRoute(const Bus& bus, const svg::Color& color) {
+    map_.StartPolyline(map_.AddStyle(MakeRouteStyle(color)));
+    for (const Stop* stop : bus.busroute) {
+        map_.AddPoint(stop_points_[stop->id]);
+    }
+}
+
+void MapRenderer::AddBusname(const std::string& busname, const Stop& stop, svg::BatchDocument::AttributesId underlayer,
+        svg::BatchDocument::AttributesId label, svg::BatchDocument::AttributesId font) {
+    const svg::Point position = stop_points_[stop.id];
+    const auto font_size = static_cast<uint32_t>(settings_.bus_label_font_size);
+    map_.AddText(position, settings_.bus_label_offset, font_size, font, busname, underlayer);
+    map_.AddText(position, settings_.bus_label_offset, font_size, font, busname, label);
 }
 
 void MapRenderer::AddBusnames(const Bus& bus, const svg::Color& color) {
     using namespace svg;
+    const auto underlayer = map_.AddStyle(MakeUnderlayerStyle());
+    const auto label = map_.AddStyle(Style{color});
+    const auto font = map_.AddFont(settings_.font_family, settings_.font_weight);
     auto first_stop = bus.busroute.front();
-    map_.Add(RenderBusnameUnderlayer(bus.busname, *first_stop));
-    map_.Add(RenderBusname(bus.busname, *first_stop, color));
+    AddBusname(bus.busname, *first_stop, underlayer, label, font);
     auto final_stop = bus.busroute.at(bus.busroute.size() / 2);
     if (!bus.is_roundtrip && final_stop->stopname != first_stop->stopname) {
-        map_.Add(RenderBusnameUnderlayer(bus.busname, *final_stop));
-        map_.Add(RenderBusname(bus.busname, *final_stop, color));
+        AddBusname(bus.busname, *final_stop, underlayer, label, font);
     }
 }
 
-void MapRenderer::AddStop(const Stop& stop) {
-    using namespace svg;
-    Circle circle;
-    circle.SetCenter(proj_(stop.coordinates)).SetRadius(settings_.stop_radius).SetFillColor("white");
-    map_.Add(circle);
+void MapRenderer::AddStopname(const Stop& stop, svg::BatchDocument::AttributesId underlayer,
+        svg::BatchDocument::AttributesId label, svg::BatchDocument::AttributesId font) {
+    const svg::Point position = stop_points_[stop.id];
+    const auto font_size = static_cast<uint32_t>(settings_.stop_label_font_size);
+    map_.AddText(position, settings_.stop_label_offset, font_size, font, stop.stopname, underlayer);
+    map_.AddText(position, settings_.stop_label_offset, font_size, font, stop.stopname, label);
 }
 
-svg::Text MapRenderer::RenderStopname(const Stop& stop) const {
-    svg::Text result;
-    result.SetPosition(proj_(stop.coordinates)).SetOffset(settings_.stop_label_offset);
-    result.SetFontSize(settings_.stop_label_font_size).SetFontFamily(settings_.font_family);
-    result.SetData(stop.stopname).SetFillColor("black");
-    return result;
+const MapTileIndex& MapRenderer::GetTileIndex(const TransportCatalogue& catalogue) {
+    std::call_once(tile_index_built_, [&] {
+        tile_index_ = std::make_unique<MapTileIndex>(catalogue.GetAllBuses(), catalogue.GetAllStopsInRoutes(),
+            stop_points_, settings_.width, settings_.height);
+    });
+    return *tile_index_;
 }
 
-svg::Text MapRenderer::RenderStopnameUnderlayer(const Stop& stop) const {
+// Слои выводятся в том же порядке, что и на полной карте
+std::string MapRenderer::RenderTile(const MapTileIndex& index, const Viewport& viewport) const {
     using namespace svg;
-    Text result = RenderStopname(stop);
-    result.SetFillColor(settings_.underlayer_color).SetStrokeColor(settings_.underlayer_color);
-    result.SetStrokeWidth(settings_.underlayer_width);
-    result.SetStrokeLineCap(StrokeLineCap::ROUND).SetStrokeLineJoin(StrokeLineJoin::ROUND);
+    const double margin = GetTileMargin() / viewport.scale;
+    const Rect area{{viewport.area.min.x - margin, viewport.area.min.y - margin},
+        {viewport.area.max.x + margin, viewport.area.max.y + margin}};
+    const auto& buses = index.GetBuses();
+    const auto& route_points = index.GetRoutePoints();
+    std::vector<size_t> color_indexes(buses.size());
+    for (size_t bus_index = 0, color_index = 0; bus_index < buses.size(); ++bus_index) {
+        color_indexes[bus_index] = buses[bus_index].busroute.empty() ? 0 : color_index++;
+    }
+    auto get_color = [this, &color_indexes](size_t bus_index) -> const Color& {
+        return settings_.color_palette[color_indexes[bus_index] % settings_.color_palette.size()];
+    };
+
+    const std::vector<bool>* simplified = nullptr;
+    if (settings_.simplification_tolerance > 0.0) {
+        simplified = &index.GetSimplifiedVertices(viewport.GetZoom(), settings_.simplification_tolerance);
+    }
+
+    BatchDocument tile = MakeDocument();
+    for (const auto& piece : index.FindRoutePieces(area)) {
+        tile.StartPolyline(tile.AddStyle(MakeRouteStyle(get_color(piece.bus_index))));
+        for (uint32_t i = piece.begin; i < piece.end; ++i) {
+            // Концы участка остаются, чтобы линия доходила до края плитки
+            if (simplified == nullptr || (*simplified)[i] || i == piece.begin || i + 1 == piece.end) {
+                tile.AddPoint(viewport(route_points[i]));
+            }
+        }
+    }
+
+    const auto underlayer = tile.AddStyle(MakeUnderlayerStyle());
+    const auto bus_font = tile.AddFont(settings_.font_family, settings_.font_weight);
+    const auto bus_font_size = static_cast<uint32_t>(settings_.bus_label_font_size);
+    auto add_busname = [&](const Bus& bus, Point point, BatchDocument::AttributesId label) {
+        if (area.Contains(point)) {
+            tile.AddText(viewport(point), settings_.bus_label_offset, bus_font_size, bus_font, bus.busname, underlayer);
+            tile.AddText(viewport(point), settings_.bus_label_offset, bus_font_size, bus_font, bus.busname, label);
+        }
+    };
+    for (size_t bus_index = 0; bus_index < buses.size(); ++bus_index) {
+        const Bus& bus = buses[bus_index];
+        if (bus.busroute.empty()) {
+            continue;
+        }
+        const auto label = tile.AddStyle(Style{get_color(bus_index)});
+        add_busname(bus, index.GetRoutePoint(bus_index, 0), label);
+        const size_t final_position = bus.busroute.size() / 2;
+        if (!bus.is_roundtrip && bus.busroute[final_position]->stopname != bus.busroute.front()->stopname) {
+            add_busname(bus, index.GetRoutePoint(bus_index, final_position), label);
+        }
+    }
+
+    const auto visible_stops = index.FindStops(area);
+    const auto circle = tile.AddStyle(Style{Color{"white"}});
+    for (uint32_t stop : visible_stops) {
+        tile.AddCircle(viewport(index.GetStopPoint(stop)), settings_.stop_radius, circle);
+    }
+    const auto stop_label = tile.AddStyle(Style{Color{"black"}});
+    const auto stop_font = tile.AddFont(settings_.font_family, {});
+    const auto stop_font_size = static_cast<uint32_t>(settings_.stop_label_font_size);
+    for (uint32_t stop : visible_stops) {
+        const Point point = viewport(index.GetStopPoint(stop));
+        const std::string& name = index.GetStops()[stop].stopname;
+        tile.AddText(point, settings_.stop_label_offset, stop_font_size, stop_font, name, underlayer);
+        tile.AddText(point, settings_.stop_label_offset, stop_font_size, stop_font, name, stop_label);
+    }
+
+    std::string result;
+    tile.RenderChunks([&result](std::string_view chunk) {
+        json::AppendEscaped(result, chunk);
+    });
     return result;
 }
 
-void MapRenderer::AddStopname(const Stop& stop) {
-    using namespace svg;
-    map_.Add(RenderStopnameUnderlayer(stop));
-    map_.Add(RenderStopname(stop));
+// Подпись начинается у точки и тянется вправо, поэтому запас рассчитан на несколько
+// символов самого крупного шрифта
+double MapRenderer::GetTileMargin() const {
+    const double offset = std::max({std::abs(settings_.bus_label_offset.x), std::abs(settings_.bus_label_offset.y),
+        std::abs(settings_.stop_label_offset.x), std::abs(settings_.stop_label_offset.y)});
+    const int font_size = std::max(settings_.bus_label_font_size, settings_.stop_label_font_size);
+    return std::max(settings_.line_width, settings_.stop_radius) + settings_.underlayer_width
+        + offset + font_size * LABEL_MARGIN_EM;
+}
+
+svg::BatchDocument MapRenderer::MakeDocument() const {
+    return svg::BatchDocument(settings_.compact_svg ? svg::StyleMode::CLASSES : svg::StyleMode::INLINE,
+        settings_.path_precision);
 }
 
 } // namespace renderer
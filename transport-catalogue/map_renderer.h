@@ -2,15 +2,24 @@
 
 #include "domain.h"
 #include "geo.h"
+#include "map_geometry.h"
+#include "map_tiles.h"
 #include "svg.h"
+#include "svg_batch.h"
+#include "thread_pool.h"
+#include "transport_catalogue.h"
 
 #include <algorithm>
 #include <cstdlib>
 #include <deque>
 #include <iostream>
+#include <list>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <set>
+#include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -33,8 +42,17 @@ struct RenderSettings {
     std::vector<svg::Color> color_palette;
     std::string font_family = "Verdana";
     std::string font_weight = "bold";
+    // Допустимое отклонение упрощённых линий маршрутов в пикселях. 0 отключает упрощение
+    double simplification_tolerance = 0.0;
+    // Стили выводятся классами CSS в блоке <style>, а не атрибутами каждого элемента
+    bool compact_svg = false;
+    // Если задано, линии маршрутов выводятся элементами <path> с относительными координатами
+    // и этим числом знаков после запятой
+    std::optional<int> path_precision;
 };
 
+bool operator==(const RenderSettings& lhs, const RenderSettings& rhs);
+
 inline const double EPSILON = 1e-6; /*
 bool IsZero(double value) {
     return std::abs(value) < EPSILON;
@@ -57,26 +75,52 @@ public:
         const auto [left_it, right_it] = std::minmax_element(
             points_begin, points_end,
             [](auto lhs, auto rhs) { return lhs.lng < rhs.lng; });
-        min_lon_ = left_it->lng;
-        const double max_lon = right_it->lng;
 
         // Находим точки с минимальной и максимальной широтой
         const auto [bottom_it, top_it] = std::minmax_element(
             points_begin, points_end,
             [](auto lhs, auto rhs) { return lhs.lat < rhs.lat; });
-        const double min_lat = bottom_it->lat;
-        max_lat_ = top_it->lat;
+
+        SetBounds({{bottom_it->lat, left_it->lng}, {top_it->lat, right_it->lng}}, max_width, max_height);
+    }
+
+    // bounds — уже найденные границы проецируемых точек
+    SphereProjector(const geo::Area& bounds, double max_width, double max_height, double padding)
+        : padding_(padding) //
+    {
+        SetBounds(bounds, max_width, max_height);
+    }
+
+    // Проецирует широту и долготу в координаты внутри SVG-изображения
+    svg::Point operator()(geo::Coordinates coords) const {
+        return {
+            (coords.lng - min_lon_) * zoom_coeff_ + padding_,
+            (max_lat_ - coords.lat) * zoom_coeff_ + padding_
+        };
+    }
+
+private:
+    double padding_;
+    double min_lon_ = 0;
+    double max_lat_ = 0;
+    double zoom_coeff_ = 0;
+
+    void SetBounds(const geo::Area& bounds, double max_width, double max_height) {
+        min_lon_ = bounds.min.lng;
+        const double max_lon = bounds.max.lng;
+        const double min_lat = bounds.min.lat;
+        max_lat_ = bounds.max.lat;
 
         // Вычисляем коэффициент масштабирования вдоль координаты x
         std::optional<double> width_zoom;
         if (!(std::abs(max_lon - min_lon_) < EPSILON)) {
-            width_zoom = (max_width - 2 * padding) / (max_lon - min_lon_);
+            width_zoom = (max_width - 2 * padding_) / (max_lon - min_lon_);
         }
 
         // Вычисляем коэффициент масштабирования вдоль координаты y
         std::optional<double> height_zoom;
         if (!(std::abs(max_lat_ - min_lat) < EPSILON)) {
-            height_zoom = (max_height - 2 * padding) / (max_lat_ - min_lat);
+            height_zoom = (max_height - 2 * padding_) / (max_lat_ - min_lat);
         }
 
         if (width_zoom && height_zoom) {
@@ -91,50 +135,129 @@ public:
             zoom_coeff_ = *height_zoom;
         }
     }
-
-    // Проецирует широту и долготу в координаты внутри SVG-изображения
-    svg::Point operator()(geo::Coordinates coords) const {
-        return {
-            (coords.lng - min_lon_) * zoom_coeff_ + padding_,
-            (max_lat_ - coords.lat) * zoom_coeff_ + padding_
-        };
-    }
-
-private:
-    double padding_;
-    double min_lon_ = 0;
-    double max_lat_ = 0;
-    double zoom_coeff_ = 0;
 };
 
 class MapRenderer {
 public:
-    explicit MapRenderer(const RenderSettings& settings, const std::vector<geo::Coordinates>& coords);
+    // Масштаб карты определяют остановки, через которые проходят маршруты
+    explicit MapRenderer(const RenderSettings& settings, const StopCoordinates& coords);
 
-    const svg::Document* RenderRoutes(const std::deque<Bus>& buses, const std::deque<Stop>& stops);
+    // Отрисовывает карту при первом вызове и затем возвращает сохранённый SVG-документ,
+    // уже экранированный для вывода внутри строки JSON. Рендерер принадлежит одной версии
+    // справочника, поэтому карта остаётся актуальной. Можно вызывать из нескольких потоков.
+    // Если задан pool, части документа выводятся в его потоках
+    std::shared_ptr<const std::string> GetMap(const TransportCatalogue& catalogue, ThreadPool* pool = nullptr);
+
+    // Отрисовывает только то, что видно на плитке, в масштабе плитки. Результат экранирован
+    // так же, как у GetMap. Недавно запрошенные плитки кэшируются. Возвращает nullptr,
+    // если плитка лежит вне карты
+    std::shared_ptr<const std::string> GetTile(const TransportCatalogue& catalogue, const TileRequest& request);
+
+    // Маршруты и точки остановок карты без отрисовки SVG. Вычисляется один раз
+    std::shared_ptr<const MapGeometry> GetGeometry(const TransportCatalogue& catalogue);
+
+    // Результат EncodeMapGeometry в base64. Вычисляется один раз
+    std::shared_ptr<const std::string> GetEncodedGeometry(const TransportCatalogue& catalogue);
+
+    // Берёт отрисованные фрагменты карты рендерера предыдущей версии справочника с теми же
+    // настройками. Если границы карты не сдвинулись, GetMap отрисует заново только
+    // изменившиеся маршруты и остановки
+    void ReuseFragments(const MapRenderer& previous);
 
 private:
+    using RecentTiles = std::list<std::pair<std::string, std::shared_ptr<const std::string>>>;
+
+    // Элементы карты одного маршрута, уже экранированные для JSON. Остальные поля
+    // определяют, совпадает ли фрагмент с маршрутом новой версии
+    struct BusFragment {
+        size_t palette_index = 0;
+        bool is_roundtrip = false;
+        std::vector<size_t> stop_ids;
+        std::vector<svg::Point> points;
+        std::string route;
+        std::string labels;
+
+        bool IsSameRoute(const BusFragment& other) const;
+    };
+
+    struct StopFragment {
+        svg::Point point;
+        std::string circle;
+        std::string label;
+    };
+
+    // Фрагменты по названиям маршрутов и остановок
+    struct MapFragments {
+        geo::Area bounds;
+        std::unordered_map<std::string, BusFragment> buses;
+        std::unordered_map<std::string, StopFragment> stops;
+    };
+
+    // Фрагмент, элементы которого [begin, end) документа map_ ещё нужно вывести в out
+    struct PendingFragment {
+        std::string* out;
+        size_t begin;
+        size_t end;
+    };
+
     RenderSettings settings_;
+    // Границы остановок маршрутов, по которым построена проекция
+    geo::Area bounds_;
     SphereProjector proj_;
-    svg::Document map_;
+    // Проекции остановок по Stop::id, вычисленные один раз
+    std::vector<svg::Point> stop_points_;
+    svg::BatchDocument map_;
+    std::once_flag map_rendered_;
+    std::shared_ptr<const std::string> map_json_;
+    // До отрисовки карты — фрагменты предыдущей версии, после — свои
+    mutable std::mutex fragments_mutex_;
+    std::shared_ptr<const MapFragments> fragments_;
 
-    SphereProjector SetProjector(const std::vector<geo::Coordinates>& coords);
+    std::once_flag geometry_built_;
+    std::shared_ptr<const MapGeometry> geometry_;
+    std::once_flag geometry_encoded_;
+    std::shared_ptr<const std::string> encoded_geometry_;
 
-    void AddRoute(const Bus& bus, const svg::Color& color);
+    std::once_flag tile_index_built_;
+    std::unique_ptr<MapTileIndex> tile_index_;
+    std::mutex tiles_mutex_;
+    // Плитки от последней запрошенной к самой давней
+    RecentTiles recent_tiles_;
+    std::unordered_map<std::string, RecentTiles::iterator> tile_positions_;
+
+    static geo::Area FindBounds(const StopCoordinates& coords);
+
+    void ProjectStops(const StopCoordinates& coords);
+
+    // Заполняет fragments, беря неизменившиеся фрагменты из previous, и возвращает карту целиком
+    std::string RenderFragments(const std::deque<Bus>& buses, const std::deque<Stop>& stops,
+        const MapFragments* previous, MapFragments& fragments, ThreadPool* pool);
 
-    svg::Text RenderBusname(const std::string& busname, const Stop& stop, const svg::Color& color = "none") const;
+    void RenderPending(const std::vector<PendingFragment>& pending, ThreadPool* pool) const;
 
-    svg::Text RenderBusnameUnderlayer(const std::string& busname, const Stop& stop) const;
+    svg::Style MakeRouteStyle(const svg::Color& color) const;
+
+    svg::Style MakeUnderlayerStyle() const;
+
+    void AddRoute(const Bus& bus, const svg::Color& color);
+
+    void AddBusname(const std::string& busname, const Stop& stop, svg::BatchDocument::AttributesId underlayer,
+        svg::BatchDocument::AttributesId label, svg::BatchDocument::AttributesId font);
 
     void AddBusnames(const Bus& bus, const svg::Color& color);
 
-    void AddStop(const Stop& stop);
+    void AddStopname(const Stop& stop, svg::BatchDocument::AttributesId underlayer,
+        svg::BatchDocument::AttributesId label, svg::BatchDocument::AttributesId font);
+
+    const MapTileIndex& GetTileIndex(const TransportCatalogue& catalogue);
+
+    std::string RenderTile(const MapTileIndex& index, const Viewport& viewport) const;
+
+    // Запас вокруг плитки, в котором элементы ещё могут её задеть, в пикселях плитки
+    double GetTileMargin() const;
 
-    svg::Text RenderStopname(const Stop& stop) const;
-    
-    svg::Text RenderStopnameUnderlayer(const Stop& stop) const;
-    
-    void AddStopname(const Stop& stop);
+    // Пустой документ с форматом вывода из настроек
+    svg::BatchDocument MakeDocument() const;
 };
 
 } // namespace renderer
@@ -0,0 +1,288 @@
+#include "map_tiles.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace transport_catalogue {
+
+namespace renderer {
+
+namespace {
+
+constexpr size_t MAX_GRID_SIDE = 512;
+// Среднее число отрезков в ячейке сетки
+constexpr double SEGMENTS_PER_CELL = 2.0;
+constexpr double MIN_CELL_SIZE = 1e-9;
+
+// Отрезок задевает прямоугольник, если их габариты пересекаются и углы прямоугольника
+// не лежат строго по одну сторону от прямой отрезка
+bool SegmentIntersects(svg::Point from, svg::Point to, const Rect& rect) {
+    const Rect bounds{{std::min(from.x, to.x), std::min(from.y, to.y)}, {std::max(from.x, to.x), std::max(from.y, to.y)}};
+    if (!bounds.Intersects(rect)) {
+        return false;
+    }
+    auto side = [from, to](double x, double y) {
+        return (to.x - from.x) * (y - from.y) - (to.y - from.y) * (x - from.x);
+    };
+    const double sides[] = {side(rect.min.x, rect.min.y), side(rect.max.x, rect.min.y),
+        side(rect.min.x, rect.max.y), side(rect.max.x, rect.max.y)};
+    const bool all_positive = std::all_of(std::begin(sides), std::end(sides), [](double value) { return value > 0.0; });
+    const bool all_negative = std::all_of(std::begin(sides), std::end(sides), [](double value) { return value < 0.0; });
+    return !all_positive && !all_negative;
+}
+
+double GetSegmentDistance(svg::Point point, svg::Point from, svg::Point to) {
+    const double dx = to.x - from.x;
+    const double dy = to.y - from.y;
+    const double length2 = dx * dx + dy * dy;
+    double t = 0.0;
+    if (length2 > 0.0) {
+        t = std::clamp(((point.x - from.x) * dx + (point.y - from.y) * dy) / length2, 0.0, 1.0);
+    }
+    return std::hypot(point.x - (from.x + t * dx), point.y - (from.y + t * dy));
+}
+
+// Отмечает в kept вершины [begin, end), которые остаются после упрощения. Концы всегда остаются
+void SimplifyPolyline(const std::vector<svg::Point>& points, size_t begin, size_t end, double tolerance,
+        std::vector<bool>& kept) {
+    if (end - begin < 3) {
+        std::fill(kept.begin() + begin, kept.begin() + end, true);
+        return;
+    }
+    kept[begin] = true;
+    kept[end - 1] = true;
+    std::vector<std::pair<size_t, size_t>> ranges{{begin, end - 1}};
+    while (!ranges.empty()) {
+        const auto [first, last] = ranges.back();
+        ranges.pop_back();
+        double max_distance = 0.0;
+        size_t farthest = first;
+        for (size_t i = first + 1; i < last; ++i) {
+            const double distance = GetSegmentDistance(points[i], points[first], points[last]);
+            if (distance > max_distance) {
+                max_distance = distance;
+                farthest = i;
+            }
+        }
+        if (max_distance > tolerance) {
+            kept[farthest] = true;
+            ranges.emplace_back(first, farthest);
+            ranges.emplace_back(farthest, last);
+        }
+    }
+}
+
+} // namespace
+
+int Viewport::GetZoom() const {
+    const double zoom = std::ceil(std::log2(std::max(scale, 1.0)));
+    return static_cast<int>(std::min(zoom, static_cast<double>(MAX_TILE_ZOOM)));
+}
+
+MapTileIndex::MapTileIndex(std::deque<Bus> buses, std::deque<Stop> stops,
+        const std::vector<svg::Point>& stop_points, double width, double height)
+    : buses_(std::move(buses)), stops_(std::move(stops)), bounds_{{0.0, 0.0}, {width, height}} {
+    std::vector<uint32_t> segments;
+    route_offsets_.reserve(buses_.size() + 1);
+    for (const auto& bus : buses_) {
+        const auto offset = static_cast<uint32_t>(route_points_.size());
+        route_offsets_.push_back(offset);
+        for (const Stop* stop : bus.busroute) {
+            route_points_.push_back(stop_points[stop->id]);
+        }
+        const size_t size = bus.busroute.size();
+        const size_t segment_count = size > 1 ? size - 1 : size;
+        for (size_t i = 0; i < segment_count; ++i) {
+            segments.push_back(offset + static_cast<uint32_t>(i));
+        }
+    }
+    route_offsets_.push_back(static_cast<uint32_t>(route_points_.size()));
+    stop_points_.reserve(stops_.size());
+    for (const auto& stop : stops_) {
+        stop_points_.push_back(stop_points[stop.id]);
+    }
+
+    for (const auto& point : route_points_) {
+        bounds_.min = {std::min(bounds_.min.x, point.x), std::min(bounds_.min.y, point.y)};
+        bounds_.max = {std::max(bounds_.max.x, point.x), std::max(bounds_.max.y, point.y)};
+    }
+    for (const auto& point : stop_points_) {
+        bounds_.min = {std::min(bounds_.min.x, point.x), std::min(bounds_.min.y, point.y)};
+        bounds_.max = {std::max(bounds_.max.x, point.x), std::max(bounds_.max.y, point.y)};
+    }
+    side_ = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(segments.size()) / SEGMENTS_PER_CELL)));
+    side_ = std::clamp<size_t>(side_, 1, MAX_GRID_SIDE);
+    cell_width_ = std::max((bounds_.max.x - bounds_.min.x) / side_, MIN_CELL_SIZE);
+    cell_height_ = std::max((bounds_.max.y - bounds_.min.y) / side_, MIN_CELL_SIZE);
+
+    FillCells(segments, [this](uint32_t segment) {
+        return GetSegmentRect(segment);
+    }, segment_cell_offsets_, cell_segments_);
+    std::vector<uint32_t> stop_ids(stops_.size());
+    for (size_t i = 0; i < stop_ids.size(); ++i) {
+        stop_ids[i] = static_cast<uint32_t>(i);
+    }
+    FillCells(stop_ids, [this](uint32_t stop) {
+        return Rect{stop_points_[stop], stop_points_[stop]};
+    }, stop_cell_offsets_, cell_stops_);
+}
+
+const std::deque<Bus>& MapTileIndex::GetBuses() const {
+    return buses_;
+}
+
+const std::deque<Stop>& MapTileIndex::GetStops() const {
+    return stops_;
+}
+
+const std::vector<svg::Point>& MapTileIndex::GetRoutePoints() const {
+    return route_points_;
+}
+
+svg::Point MapTileIndex::GetRoutePoint(size_t bus_index, size_t position) const {
+    return route_points_[route_offsets_[bus_index] + position];
+}
+
+svg::Point MapTileIndex::GetStopPoint(size_t stop_index) const {
+    return stop_points_[stop_index];
+}
+
+// Соседние отрезки одного маршрута склеиваются в один участок
+std::vector<MapTileIndex::RoutePiece> MapTileIndex::FindRoutePieces(const Rect& area) const {
+    std::vector<RoutePiece> result;
+    for (uint32_t segment : Find(area, segment_cell_offsets_, cell_segments_)) {
+        const size_t bus_index = std::upper_bound(route_offsets_.begin(), route_offsets_.end(), segment)
+            - route_offsets_.begin() - 1;
+        const uint32_t end = std::min(segment + 2, route_offsets_[bus_index + 1]);
+        if (!SegmentIntersects(route_points_[segment], route_points_[end - 1], area)) {
+            continue;
+        }
+        if (!result.empty() && result.back().bus_index == bus_index && result.back().end == segment + 1) {
+            result.back().end = end;
+        } else {
+            result.push_back(RoutePiece{bus_index, segment, end});
+        }
+    }
+    return result;
+}
+
+std::vector<uint32_t> MapTileIndex::FindStops(const Rect& area) const {
+    std::vector<uint32_t> result = Find(area, stop_cell_offsets_, cell_stops_);
+    result.erase(std::remove_if(result.begin(), result.end(), [this, &area](uint32_t stop) {
+        return !area.Contains(stop_points_[stop]);
+    }), result.end());
+    return result;
+}
+
+const std::vector<bool>& MapTileIndex::GetSimplifiedVertices(int zoom, double tolerance) const {
+    std::call_once(simplified_flags_[zoom], [&] {
+        // Допуск переводится в пиксели полной карты
+        const double map_tolerance = tolerance / static_cast<double>(1 << zoom);
+        std::vector<bool>& kept = simplified_vertices_[zoom];
+        kept.assign(route_points_.size(), false);
+        for (size_t bus_index = 0; bus_index + 1 < route_offsets_.size(); ++bus_index) {
+            SimplifyPolyline(route_points_, route_offsets_[bus_index], route_offsets_[bus_index + 1], map_tolerance, kept);
+        }
+    });
+    return simplified_vertices_[zoom];
+}
+
+Rect MapTileIndex::GetSegmentRect(uint32_t segment) const {
+    const svg::Point from = route_points_[segment];
+    const auto next_route = std::upper_bound(route_offsets_.begin(), route_offsets_.end(), segment);
+    const svg::Point to = segment + 1 < *next_route ? route_points_[segment + 1] : from;
+    return Rect{{std::min(from.x, to.x), std::min(from.y, to.y)}, {std::max(from.x, to.x), std::max(from.y, to.y)}};
+}
+
+size_t MapTileIndex::GetCol(double x) const {
+    const double col = std::floor((x - bounds_.min.x) / cell_width_);
+    return static_cast<size_t>(std::clamp(col, 0.0, static_cast<double>(side_ - 1)));
+}
+
+size_t MapTileIndex::GetRow(double y) const {
+    const double row = std::floor((y - bounds_.min.y) / cell_height_);
+    return static_cast<size_t>(std::clamp(row, 0.0, static_cast<double>(side_ - 1)));
+}
+
+// Раскладывает элементы по ячейкам в два прохода: подсчёт и заполнение
+template <typename GetRect>
+void MapTileIndex::FillCells(const std::vector<uint32_t>& ids, GetRect get_rect,
+        std::vector<size_t>& offsets, std::vector<uint32_t>& items) const {
+    offsets.assign(side_ * side_ + 1, 0);
+    auto for_each_cell = [this](const Rect& rect, auto action) {
+        for (size_t row = GetRow(rect.min.y); row <= GetRow(rect.max.y); ++row) {
+            for (size_t col = GetCol(rect.min.x); col <= GetCol(rect.max.x); ++col) {
+                action(row * side_ + col);
+            }
+        }
+    };
+    for (uint32_t id : ids) {
+        for_each_cell(get_rect(id), [&offsets](size_t cell) {
+            ++offsets[cell + 1];
+        });
+    }
+    for (size_t i = 1; i < offsets.size(); ++i) {
+        offsets[i] += offsets[i - 1];
+    }
+    items.resize(offsets.back());
+    std::vector<size_t> filled(offsets.begin(), offsets.end() - 1);
+    for (uint32_t id : ids) {
+        for_each_cell(get_rect(id), [&items, &filled, id](size_t cell) {
+            items[filled[cell]++] = id;
+        });
+    }
+}
+
+std::vector<uint32_t> MapTileIndex::Find(const Rect& area, const std::vector<size_t>& offsets,
+        const std::vector<uint32_t>& items) const {
+    std::vector<uint32_t> result;
+    if (!area.Intersects(bounds_)) {
+        return result;
+    }
+    for (size_t row = GetRow(area.min.y); row <= GetRow(area.max.y); ++row) {
+        for (size_t col = GetCol(area.min.x); col <= GetCol(area.max.x); ++col) {
+            const size_t cell = row * side_ + col;
+            result.insert(result.end(), items.begin() + offsets[cell], items.begin() + offsets[cell + 1]);
+        }
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+std::optional<Viewport> MakeViewport(const TileRequest& request, double width, double height,
+        const std::function<svg::Point(geo::Coordinates)>& project) {
+    Viewport result;
+    if (request.zoom) {
+        const int zoom = *request.zoom;
+        if (zoom < 0 || zoom > MAX_TILE_ZOOM) {
+            return std::nullopt;
+        }
+        const int tiles = 1 << zoom;
+        if (request.x < 0 || request.x >= tiles || request.y < 0 || request.y >= tiles) {
+            return std::nullopt;
+        }
+        result.scale = static_cast<double>(tiles);
+        result.origin = {request.x * width / tiles, request.y * height / tiles};
+    } else {
+        const geo::Area& area = request.area;
+        if (!(area.min.lat < area.max.lat && area.min.lng < area.max.lng)) {
+            return std::nullopt;
+        }
+        const svg::Point top_left = project({area.max.lat, area.min.lng});
+        const svg::Point bottom_right = project({area.min.lat, area.max.lng});
+        const double area_width = bottom_right.x - top_left.x;
+        const double area_height = bottom_right.y - top_left.y;
+        if (!(area_width > 0.0 && area_height > 0.0)) {
+            return std::nullopt;
+        }
+        result.scale = std::min(width / area_width, height / area_height);
+        result.origin = top_left;
+    }
+    result.area = Rect{result.origin, {result.origin.x + width / result.scale, result.origin.y + height / result.scale}};
+    return result;
+}
+
+} // namespace renderer
+
+} // namespace transport_catalogue
\ No newline at end of file
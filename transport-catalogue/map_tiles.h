@@ -0,0 +1,142 @@
+#pragma once
+
+#include "domain.h"
+#include "geo.h"
+#include "svg.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace transport_catalogue {
+
+namespace renderer {
+
+inline constexpr int MAX_TILE_ZOOM = 24;
+
+// Плитка карты: номер zoom/x/y либо, если zoom не задан, географическая область area
+struct TileRequest {
+    std::optional<int> zoom;
+    int x = 0;
+    int y = 0;
+    geo::Area area{{0.0, 0.0}, {0.0, 0.0}};
+};
+
+// Прямоугольник в координатах полной карты
+struct Rect {
+    svg::Point min;
+    svg::Point max;
+
+    bool Intersects(const Rect& other) const {
+        return min.x <= other.max.x && other.min.x <= max.x
+            && min.y <= other.max.y && other.min.y <= max.y;
+    }
+
+    bool Contains(svg::Point point) const {
+        return point.x >= min.x && point.x <= max.x && point.y >= min.y && point.y <= max.y;
+    }
+};
+
+// Видимая часть полной карты и масштаб, с которым она выводится в плитку
+struct Viewport {
+    svg::Point origin;
+    double scale = 1.0;
+    Rect area;
+
+    // Ближайший уровень плитки, детальность которого не меньше масштаба
+    int GetZoom() const;
+
+    svg::Point operator()(svg::Point point) const {
+        return {(point.x - origin.x) * scale, (point.y - origin.y) * scale};
+    }
+};
+
+/*
+ * Геометрия маршрутов и остановок, спроецированная на полную карту, и равномерная сетка
+ * над ней. Ячейка хранит номера отрезков маршрутов и остановок, которые её задевают.
+ * Ячейки хранятся подряд в одном массиве, cell_offsets_ задаёт границы каждой ячейки
+ */
+class MapTileIndex {
+public:
+    // Непрерывный участок маршрута: вершины [begin, end) общего массива вершин
+    struct RoutePiece {
+        size_t bus_index;
+        uint32_t begin;
+        uint32_t end;
+    };
+
+    // buses и stops — маршруты и остановки в порядке вывода на карту,
+    // stop_points — точки остановок на полной карте размером width x height по Stop::id
+    MapTileIndex(std::deque<Bus> buses, std::deque<Stop> stops,
+        const std::vector<svg::Point>& stop_points, double width, double height);
+
+    const std::deque<Bus>& GetBuses() const;
+
+    const std::deque<Stop>& GetStops() const;
+
+    const std::vector<svg::Point>& GetRoutePoints() const;
+
+    // Точка остановки с номером position в маршруте bus_index
+    svg::Point GetRoutePoint(size_t bus_index, size_t position) const;
+
+    svg::Point GetStopPoint(size_t stop_index) const;
+
+    // Участки маршрутов, задевающие area, в порядке маршрутов и вершин
+    std::vector<RoutePiece> FindRoutePieces(const Rect& area) const;
+
+    // Номера остановок внутри area по возрастанию
+    std::vector<uint32_t> FindStops(const Rect& area) const;
+
+    // Отмечает вершины маршрутов, которые остаются после упрощения по Дугласу — Пёккеру
+    // с допуском tolerance пикселей плитки уровня zoom. Результат для каждого уровня
+    // вычисляется один раз. Можно вызывать из нескольких потоков
+    const std::vector<bool>& GetSimplifiedVertices(int zoom, double tolerance) const;
+
+private:
+    std::deque<Bus> buses_;
+    std::deque<Stop> stops_;
+    std::vector<svg::Point> route_points_;
+    // Начало каждого маршрута в route_points_, последний элемент равен route_points_.size()
+    std::vector<uint32_t> route_offsets_;
+    std::vector<svg::Point> stop_points_;
+
+    mutable std::array<std::once_flag, MAX_TILE_ZOOM + 1> simplified_flags_;
+    mutable std::array<std::vector<bool>, MAX_TILE_ZOOM + 1> simplified_vertices_;
+
+    Rect bounds_;
+    double cell_width_ = 1.0;
+    double cell_height_ = 1.0;
+    size_t side_ = 1;
+    // Отрезок задаётся номером своей первой вершины. Маршрут из одной остановки
+    // представлен вырожденным отрезком
+    std::vector<size_t> segment_cell_offsets_;
+    std::vector<uint32_t> cell_segments_;
+    std::vector<size_t> stop_cell_offsets_;
+    std::vector<uint32_t> cell_stops_;
+
+    Rect GetSegmentRect(uint32_t segment) const;
+
+    size_t GetCol(double x) const;
+
+    size_t GetRow(double y) const;
+
+    template <typename GetRect>
+    void FillCells(const std::vector<uint32_t>& ids, GetRect get_rect,
+        std::vector<size_t>& offsets, std::vector<uint32_t>& items) const;
+
+    std::vector<uint32_t> Find(const Rect& area, const std::vector<size_t>& offsets,
+        const std::vector<uint32_t>& items) const;
+};
+
+// Возвращает std::nullopt для плитки вне карты или пустой области
+std::optional<Viewport> MakeViewport(const TileRequest& request, double width, double height,
+    const std::function<svg::Point(geo::Coordinates)>& project);
+
+} // namespace renderer
+
+} // namespace transport_catalogue
\ No newline at end of file
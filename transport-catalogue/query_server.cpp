@@ -0,0 +1,232 @@
+#include "query_server.h"
+
+#include "hot_reload.h"
+#include "json_reader.h"
+#include "json_writer.h"
+#include "request_handler.h"
+
+#include <cerrno>
+#include <cstring>
+#include <initializer_list>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace transport_catalogue {
+
+namespace {
+
+constexpr size_t READ_BUFFER_SIZE = 1 << 16;
+
+bool IsBlank(std::string_view line) {
+    using namespace std::literals;
+    return line.find_first_not_of(" \t\r"sv) == std::string_view::npos;
+}
+
+std::system_error MakeSystemError(const char* what) {
+    return std::system_error(errno, std::generic_category(), what);
+}
+
+int OpenListener(const std::filesystem::path& socket_path) {
+    using namespace std::literals;
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    const std::string path = socket_path.string();
+    if (path.size() >= sizeof(address.sun_path)) {
+        throw std::invalid_argument("Socket path is too long: "s + path);
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    const int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        throw MakeSystemError("socket");
+    }
+    // Сокет мог остаться от предыдущего запуска
+    unlink(path.c_str());
+    if (bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0
+            || listen(listener, SOMAXCONN) < 0) {
+        const auto error = MakeSystemError("bind");
+        close(listener);
+        throw error;
+    }
+    return listener;
+}
+
+// Отправляет части одним вызовом sendmsg, не склеивая их в общий буфер.
+// Возвращает false, если соединение разорвано
+bool SendAll(int client, std::initializer_list<std::string_view> parts) {
+    std::vector<iovec> pending;
+    pending.reserve(parts.size());
+    for (std::string_view part : parts) {
+        if (!part.empty()) {
+            pending.push_back(iovec{const_cast<char*>(part.data()), part.size()});
+        }
+    }
+    size_t first = 0;
+    while (first < pending.size()) {
+        msghdr message{};
+        message.msg_iov = pending.data() + first;
+        message.msg_iovlen = pending.size() - first;
+        ssize_t sent = sendmsg(client, &message, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            return false;
+        }
+        // Пропускаем отправленные части и сдвигаем начало первой неотправленной
+        for (; first < pending.size() && static_cast<size_t>(sent) >= pending[first].iov_len; ++first) {
+            sent -= static_cast<ssize_t>(pending[first].iov_len);
+        }
+        if (first < pending.size()) {
+            pending[first].iov_base = static_cast<char*>(pending[first].iov_base) + sent;
+            pending[first].iov_len -= static_cast<size_t>(sent);
+        }
+    }
+    return true;
+}
+
+std::string MakeErrorAnswer(std::string_view message) {
+    using namespace std::literals;
+    std::ostringstream output;
+    {
+        json::Writer writer(output, json::Writer::Format::COMPACT);
+        writer.StartDict().Key("error_message"sv).Value(message).EndDict();
+    }
+    return output.str();
+}
+
+} // namespace
+
+QueryServer::QueryServer(VersionedCatalogue& versions, ThreadPool* pool)
+    : versions_(versions), pool_(pool) {
+}
+
+std::string QueryServer::Answer(std::string_view document) {
+    json_processing::JsonReader reader;
+    reader.ParseDocument(json::FlatDocument(document).GetRoot());
+    if (reader.HasBaseRequests()) {
+        versions_.ApplyUpdate([&reader](TransportCatalogue& catalogue) {
+            reader.FillBase(catalogue);
+        });
+    }
+    auto snapshot = versions_.Acquire();
+    RequestHandler handler{snapshot->catalogue, snapshot->renderer, snapshot->router, pool_};
+    json_processing::JsonPrinter printer{handler, reader.GetStatRequests(), pool_, &snapshot->responses};
+    std::ostringstream output;
+    printer.PrintStats(output, json::Writer::Format::COMPACT);
+    return output.str();
+}
+
+void QueryServer::Serve(std::istream& input, std::ostream& output) {
+    for (std::string line; std::getline(input, line);) {
+        if (IsBlank(line)) {
+            continue;
+        }
+        // Ответ выводится на каждый документ, иначе клиент не сопоставит ответы с запросами
+        std::string answer;
+        try {
+            answer = Answer(line);
+        } catch (const std::exception& e) {
+            answer = MakeErrorAnswer(e.what());
+        }
+        output << answer << std::endl;
+    }
+}
+
+void QueryServer::ServeSocket(const std::filesystem::path& socket_path) {
+    const int listener = OpenListener(socket_path);
+    while (true) {
+        const int client = accept(listener, nullptr, nullptr);
+        if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            break;
+        }
+        {
+            std::lock_guard guard(clients_mutex_);
+            ++active_clients_;
+        }
+        std::thread([this, client] {
+            ServeClient(client);
+            close(client);
+            std::lock_guard guard(clients_mutex_);
+            --active_clients_;
+            clients_done_.notify_all();
+        }).detach();
+    }
+    const auto error = MakeSystemError("accept");
+    close(listener);
+    // Потоки клиентов ссылаются на сервер, поэтому дожидаемся их завершения
+    std::unique_lock lock(clients_mutex_);
+    clients_done_.wait(lock, [this] {
+        return active_clients_ == 0;
+    });
+    throw error;
+}
+
+void QueryServer::ServeClient(int client) {
+    std::string pending;
+    std::string buffer(READ_BUFFER_SIZE, '\0');
+    while (true) {
+        const ssize_t received = recv(client, buffer.data(), buffer.size(), 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            break;
+        }
+        pending.append(buffer.data(), static_cast<size_t>(received));
+        size_t line_begin = 0;
+        for (size_t line_end = pending.find('\n'); line_end != std::string::npos;
+                line_end = pending.find('\n', line_begin)) {
+            if (!Reply(client, std::string_view(pending).substr(line_begin, line_end - line_begin))) {
+                return;
+            }
+            line_begin = line_end + 1;
+        }
+        pending.erase(0, line_begin);
+    }
+    // Последняя строка может быть не завершена переводом строки
+    Reply(client, pending);
+}
+
+bool QueryServer::Reply(int client, std::string_view line) {
+    using namespace std::literals;
+    if (IsBlank(line)) {
+        return true;
+    }
+    std::string answer;
+    try {
+        answer = Answer(line);
+    } catch (const std::exception& e) {
+        answer = MakeErrorAnswer(e.what());
+    }
+    return SendAll(client, {answer, "\n"sv});
+}
+
+int ServeQueries(const std::filesystem::path& base_path, const std::filesystem::path& socket_path,
+        std::istream& input, std::ostream& output) {
+    auto versions = LoadVersionedCatalogue(base_path);
+    ThreadPool pool;
+    QueryServer server(*versions, &pool);
+    if (socket_path.empty()) {
+        server.Serve(input, output);
+        return 0;
+    }
+    try {
+        server.ServeSocket(socket_path);
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to serve " << socket_path.string() << ": " << e.what() << std::endl;
+    }
+    return 1;
+}
+
+} // namespace transport_catalogue
\ No newline at end of file
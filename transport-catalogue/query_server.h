@@ -0,0 +1,60 @@
+#pragma once
+
+#include "thread_pool.h"
+#include "versioned_catalogue.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+namespace transport_catalogue {
+
+// Отвечает на документы со stat_requests по один раз построенным справочнику, маршрутизатору
+// и рендереру. Документы разных клиентов обрабатываются параллельно над общей версией базы.
+// Документ с base_requests добавляет или обновляет остановки, расстояния и маршруты:
+// следующая версия базы строится через VersionedCatalogue::ApplyUpdate, пока остальные
+// клиенты продолжают получать ответы по текущей
+class QueryServer {
+public:
+    // Если задан pool, запросы одного документа выполняются в его потоках
+    explicit QueryServer(VersionedCatalogue& versions, ThreadPool* pool = nullptr);
+
+    QueryServer(const QueryServer&) = delete;
+    QueryServer& operator=(const QueryServer&) = delete;
+
+    // Возвращает ответ на документ одной строкой, без перевода строки в конце.
+    // stat_requests документа с base_requests выполняются уже по обновлённой базе
+    std::string Answer(std::string_view document);
+
+    // Читает документы из input по одному на строку и выводит ответ на каждый сразу после вычисления.
+    // Если документ не удалось обработать, вместо ответа выводится {"error_message": ...}
+    void Serve(std::istream& input, std::ostream& output);
+
+    // Принимает подключения на Unix-сокете socket_path и обслуживает каждого клиента
+    // в отдельном потоке по тому же построчному протоколу. Возвращает управление только при ошибке
+    void ServeSocket(const std::filesystem::path& socket_path);
+
+private:
+    VersionedCatalogue& versions_;
+    ThreadPool* pool_;
+    std::mutex clients_mutex_;
+    std::condition_variable clients_done_;
+    size_t active_clients_ = 0;
+
+    void ServeClient(int client);
+
+    // Возвращает false, если клиент закрыл соединение
+    bool Reply(int client, std::string_view line);
+};
+
+// Загружает базу из base_path и отвечает на запросы из input либо, если socket_path
+// не пуст, на запросы клиентов Unix-сокета. Возвращает код завершения процесса:
+// обслуживание сокета прекращается только при ошибке
+int ServeQueries(const std::filesystem::path& base_path, const std::filesystem::path& socket_path,
+    std::istream& input, std::ostream& output);
+
+} // namespace transport_catalogue
\ No newline at end of file
@@ -3,8 +3,8 @@
 namespace transport_catalogue {
 
 RequestHandler::RequestHandler(const TransportCatalogue& catalogue, 
-        renderer::MapRenderer& renderer, const TransportRouteProcessor& route_processor) 
-    : catalogue_(catalogue), renderer_(renderer), route_processor_(route_processor) {
+        renderer::MapRenderer& renderer, const TransportRouteProcessor& route_processor, ThreadPool* pool) 
+    : catalogue_(catalogue), renderer_(renderer), route_processor_(route_processor), pool_(pool) {
 }
 
 std::optional<BusInfo> RequestHandler::GetBusInfo(std::string_view bus_name) const {
@@ -15,12 +15,36 @@ const std::set<std::string>* RequestHandler::GetBusesByStop(std::string_view sto
     return catalogue_.GetStopInfo(stop_name);
 }
 
-const svg::Document* RequestHandler::RenderMap() {
-    return renderer_.RenderRoutes(catalogue_.GetAllBuses(), catalogue_.GetAllStopsInRoutes());
+std::shared_ptr<const std::string> RequestHandler::RenderMap() {
+    return renderer_.GetMap(catalogue_, pool_);
+}
+
+std::shared_ptr<const std::string> RequestHandler::RenderTile(const renderer::TileRequest& request) {
+    return renderer_.GetTile(catalogue_, request);
+}
+
+std::shared_ptr<const renderer::MapGeometry> RequestHandler::GetMapGeometry() {
+    return renderer_.GetGeometry(catalogue_);
+}
+
+std::shared_ptr<const std::string> RequestHandler::GetEncodedMapGeometry() {
+    return renderer_.GetEncodedGeometry(catalogue_);
 }
 
 std::optional<RouteInfo> RequestHandler::GetRoute(std::string_view from, std::string_view to) {
     return route_processor_.GetRoute(from, to);
 }
 
+std::vector<StopDistance> RequestHandler::GetNearestStops(geo::Coordinates point, size_t count) const {
+    return catalogue_.GetNearestStops(point, count);
+}
+
+AreaInfo RequestHandler::GetStopsInArea(const geo::Area& area) const {
+    return catalogue_.GetStopsInArea(area);
+}
+
+std::vector<std::string> RequestHandler::SearchStops(std::string_view prefix, size_t count) const {
+    return catalogue_.FindStopsByPrefix(prefix, count);
+}
+
 }
\ No newline at end of file
@@ -2,30 +2,50 @@
 
 #include "map_renderer.h"
 #include "svg.h"
+#include "thread_pool.h"
 #include "transport_catalogue.h"
 #include "transport_router.h"
 
+#include <memory>
+#include <string>
 #include <unordered_set>
 
 namespace transport_catalogue {
 
 class RequestHandler {
 public:
+    // Если задан pool, карта отрисовывается в его потоках
     explicit RequestHandler(const TransportCatalogue& catalogue, renderer::MapRenderer& renderer,
-        const TransportRouteProcessor& route_processor);
+        const TransportRouteProcessor& route_processor, ThreadPool* pool = nullptr);
 
     std::optional<BusInfo> GetBusInfo(std::string_view bus_name) const;
 
     const std::set<std::string>* GetBusesByStop(std::string_view stop_name) const;
 
-    const svg::Document* RenderMap();
+    // Возвращает SVG-документ карты, экранированный для строки JSON. Карта отрисовывается один раз
+    std::shared_ptr<const std::string> RenderMap();
+
+    // Возвращает nullptr для плитки вне карты
+    std::shared_ptr<const std::string> RenderTile(const renderer::TileRequest& request);
+
+    std::shared_ptr<const renderer::MapGeometry> GetMapGeometry();
+
+    // Геометрия карты в двоичном виде, закодированная в base64
+    std::shared_ptr<const std::string> GetEncodedMapGeometry();
 
     std::optional<RouteInfo> GetRoute(std::string_view from, std::string_view to);
 
+    std::vector<StopDistance> GetNearestStops(geo::Coordinates point, size_t count) const;
+
+    AreaInfo GetStopsInArea(const geo::Area& area) const;
+
+    std::vector<std::string> SearchStops(std::string_view prefix, size_t count) const;
+
 private:
     const TransportCatalogue& catalogue_;
     renderer::MapRenderer& renderer_;
     const TransportRouteProcessor& route_processor_;
+    ThreadPool* pool_;
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,42 @@
+#include "response_cache.h"
+
+namespace transport_catalogue {
+
+namespace json_processing {
+
+size_t SerializedResponse::GetSize() const {
+    return sizeof(SerializedResponse) + before.size() + after.size();
+}
+
+ResponseCache::ResponseCache(size_t max_bytes)
+    : max_bytes_(max_bytes) {
+}
+
+std::shared_ptr<const SerializedResponse> ResponseCache::Find(Kind kind, json::Writer::Format format,
+        std::string_view name) const {
+    std::lock_guard guard(mutex_);
+    const Responses& responses = responses_[GetIndex(kind, format)];
+    const auto it = responses.find(name);
+    return it == responses.end() ? nullptr : it->second;
+}
+
+// Одновременно записанные ответы на один запрос совпадают, остаётся первый
+void ResponseCache::Insert(Kind kind, json::Writer::Format format, std::string_view name,
+        std::shared_ptr<const SerializedResponse> response) {
+    const size_t size = name.size() + response->GetSize();
+    std::lock_guard guard(mutex_);
+    Responses& responses = responses_[GetIndex(kind, format)];
+    if (bytes_ + size > max_bytes_ || responses.count(name) > 0) {
+        return;
+    }
+    responses.emplace(names_.emplace_back(name), std::move(response));
+    bytes_ += size;
+}
+
+size_t ResponseCache::GetIndex(Kind kind, json::Writer::Format format) {
+    return static_cast<size_t>(kind) * 2 + (format == json::Writer::Format::PRETTY ? 0 : 1);
+}
+
+} // namespace json_processing
+
+} // namespace transport_catalogue
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "json_writer.h"
+
+#include <array>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace transport_catalogue {
+
+namespace json_processing {
+
+// Ответ на запрос, заранее записанный в JSON в одном из форматов вывода.
+// Номер запроса вставляется между before и after
+struct SerializedResponse {
+    std::string before;
+    std::string after;
+
+    size_t GetSize() const;
+};
+
+// Ответы на запросы Bus и Stop одной версии справочника. Ответ зависит только от названия
+// и формата вывода, поэтому записывается один раз. Когда кэш занимает max_bytes, новые ответы
+// в него больше не добавляются. Можно использовать из нескольких потоков
+class ResponseCache {
+public:
+    enum class Kind {
+        BUS,
+        STOP
+    };
+
+    static constexpr size_t DEFAULT_MAX_BYTES = 64 << 20;
+
+    explicit ResponseCache(size_t max_bytes = DEFAULT_MAX_BYTES);
+
+    // Возвращает nullptr, если ответа нет. Не выделяет память
+    std::shared_ptr<const SerializedResponse> Find(Kind kind, json::Writer::Format format, std::string_view name) const;
+
+    void Insert(Kind kind, json::Writer::Format format, std::string_view name,
+        std::shared_ptr<const SerializedResponse> response);
+
+private:
+    // Ключи ссылаются на названия в names_
+    using Responses = std::unordered_map<std::string_view, std::shared_ptr<const SerializedResponse>>;
+
+    size_t max_bytes_;
+    mutable std::mutex mutex_;
+    // По одному словарю на сочетание вида запроса и формата
+    std::array<Responses, 4> responses_;
+    // Адреса элементов deque не меняются при добавлении в конец
+    std::deque<std::string> names_;
+    size_t bytes_ = 0;
+
+    static size_t GetIndex(Kind kind, json::Writer::Format format);
+};
+
+} // namespace json_processing
+
+} // namespace transport_catalogue
\ No newline at end of file
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace snapshot {
+
+// Хранит текущую неизменяемую версию объекта и публикует новые версии атомарно.
+// Читатель закрепляет версию, записывая текущую эпоху в свободный слот, и не берёт блокировок.
+// Писатель заменяет указатель, увеличивает эпоху и освобождает старые версии только тогда,
+// когда не осталось читателей, закрепившихся в более ранних эпохах.
+// Если одновременно закреплено больше MAX_READERS версий, остальные читатели
+// записывают эпоху в общий список под мьютексом
+template <typename Version>
+class EpochSnapshots {
+public:
+    static constexpr size_t MAX_READERS = 256;
+
+    class Pin {
+    public:
+        Pin(Pin&& other) noexcept
+            : owner_(std::exchange(other.owner_, nullptr))
+            , slot_(std::exchange(other.slot_, nullptr))
+            , epoch_(other.epoch_)
+            , version_(std::exchange(other.version_, nullptr)) {
+        }
+
+        Pin(const Pin&) = delete;
+        Pin& operator=(const Pin&) = delete;
+        Pin& operator=(Pin&&) = delete;
+
+        ~Pin() {
+            if (owner_ != nullptr) {
+                owner_->Release(slot_, epoch_);
+            }
+        }
+
+        const Version& operator*() const {
+            return *version_;
+        }
+
+        const Version* operator->() const {
+            return version_;
+        }
+
+    private:
+        friend class EpochSnapshots;
+
+        Pin(const EpochSnapshots* owner, std::atomic<uint64_t>* slot, uint64_t epoch, const Version* version)
+            : owner_(owner)
+            , slot_(slot)
+            , epoch_(epoch)
+            , version_(version) {
+        }
+
+        const EpochSnapshots* owner_;
+        // nullptr, если эпоха записана в overflow_epochs_
+        std::atomic<uint64_t>* slot_;
+        uint64_t epoch_;
+        const Version* version_;
+    };
+
+    explicit EpochSnapshots(std::unique_ptr<Version> initial)
+        : current_(initial.release()) {
+    }
+
+    EpochSnapshots(const EpochSnapshots&) = delete;
+    EpochSnapshots& operator=(const EpochSnapshots&) = delete;
+
+    // К моменту разрушения все Pin должны быть освобождены
+    ~EpochSnapshots() {
+        delete current_.load();
+    }
+
+    Pin Acquire() const {
+        const size_t start = std::hash<std::thread::id>{}(std::this_thread::get_id()) % MAX_READERS;
+        for (size_t i = 0; i < MAX_READERS; ++i) {
+            auto& slot = reader_epochs_[(start + i) % MAX_READERS];
+            uint64_t expected = 0;
+            const uint64_t epoch = epoch_.load();
+            if (slot.load(std::memory_order_relaxed) == 0 && slot.compare_exchange_strong(expected, epoch)) {
+                return Pin{this, &slot, epoch, current_.load()};
+            }
+        }
+        // Все слоты заняты: закрепляемся под мьютексом, не дожидаясь освобождения слота
+        uint64_t epoch;
+        {
+            std::lock_guard guard(overflow_mutex_);
+            epoch = epoch_.load();
+            overflow_epochs_.insert(epoch);
+        }
+        return Pin{this, nullptr, epoch, current_.load()};
+    }
+
+    void Publish(std::unique_ptr<Version> version) {
+        std::lock_guard guard(writer_mutex_);
+        std::unique_ptr<Version> previous(current_.exchange(version.release()));
+        const uint64_t retire_epoch = epoch_.fetch_add(1) + 1;
+        retired_.push_back(Retired{retire_epoch, std::move(previous)});
+        has_retired_.store(true);
+        ReclaimLocked();
+    }
+
+    // Освобождает версии, которые больше никто не читает. Возвращает число ещё не освобождённых
+    size_t Reclaim() const {
+        std::lock_guard guard(writer_mutex_);
+        return ReclaimLocked();
+    }
+
+    uint64_t GetEpoch() const {
+        return epoch_.load();
+    }
+
+private:
+    struct Retired {
+        uint64_t epoch;
+        std::unique_ptr<Version> version;
+    };
+
+    std::atomic<Version*> current_;
+    std::atomic<uint64_t> epoch_{1};
+    mutable std::array<std::atomic<uint64_t>, MAX_READERS> reader_epochs_{};
+    mutable std::mutex writer_mutex_;
+    mutable std::vector<Retired> retired_;
+    mutable std::atomic<bool> has_retired_{false};
+    mutable std::mutex overflow_mutex_;
+    mutable std::multiset<uint64_t> overflow_epochs_;
+
+    void Release(std::atomic<uint64_t>* slot, uint64_t epoch) const {
+        if (slot != nullptr) {
+            slot->store(0);
+        } else {
+            std::lock_guard guard(overflow_mutex_);
+            overflow_epochs_.erase(overflow_epochs_.find(epoch));
+        }
+        TryReclaim();
+    }
+
+    // Вызывается читателем при освобождении версии и никогда не ждёт писателя
+    void TryReclaim() const {
+        if (!has_retired_.load()) {
+            return;
+        }
+        std::unique_lock guard(writer_mutex_, std::try_to_lock);
+        if (guard.owns_lock()) {
+            ReclaimLocked();
+        }
+    }
+
+    size_t ReclaimLocked() const {
+        uint64_t min_active = UINT64_MAX;
+        for (const auto& slot : reader_epochs_) {
+            const uint64_t epoch = slot.load();
+            if (epoch != 0 && epoch < min_active) {
+                min_active = epoch;
+            }
+        }
+        {
+            std::lock_guard guard(overflow_mutex_);
+            if (!overflow_epochs_.empty()) {
+                min_active = std::min(min_active, *overflow_epochs_.begin());
+            }
+        }
+        std::vector<Retired> still_used;
+        for (auto& retired : retired_) {
+            if (retired.epoch > min_active) {
+                still_used.push_back(std::move(retired));
+            }
+        }
+        retired_ = std::move(still_used);
+        has_retired_.store(!retired_.empty());
+        return retired_.size();
+    }
+};
+
+} // namespace snapshot
\ No newline at end of file
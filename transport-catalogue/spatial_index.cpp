@@ -0,0 +1,188 @@
+#define _USE_MATH_DEFINES
+#include "spatial_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <tuple>
+
+namespace transport_catalogue {
+
+namespace {
+
+constexpr double METERS_IN_DEGREE = 6371000.0 * M_PI / 180.0;
+constexpr double MIN_CELL_SIZE = 1e-9;
+// Запас на то, что расстояние по дуге большого круга короче расстояния вдоль параллели
+constexpr double LNG_SAFETY_FACTOR = 0.9;
+
+} // namespace
+
+StopSpatialIndex::StopSpatialIndex(const std::deque<Stop>& stops) {
+    if (stops.empty()) {
+        return;
+    }
+    min_ = stops.front().coordinates;
+    geo::Coordinates max = min_;
+    for (const auto& stop : stops) {
+        min_.lat = std::min(min_.lat, stop.coordinates.lat);
+        min_.lng = std::min(min_.lng, stop.coordinates.lng);
+        max.lat = std::max(max.lat, stop.coordinates.lat);
+        max.lng = std::max(max.lng, stop.coordinates.lng);
+    }
+
+    const size_t side = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(stops.size()))));
+    rows_ = side;
+    cols_ = side;
+    cell_lat_ = std::max((max.lat - min_.lat) / rows_, MIN_CELL_SIZE);
+    cell_lng_ = std::max((max.lng - min_.lng) / cols_, MIN_CELL_SIZE);
+    const double max_abs_lat = std::max(std::abs(min_.lat), std::abs(max.lat));
+    lng_meters_factor_ = METERS_IN_DEGREE * std::cos(max_abs_lat * M_PI / 180.0) * LNG_SAFETY_FACTOR;
+
+    cell_offsets_.assign(rows_ * cols_ + 1, 0);
+    for (const auto& stop : stops) {
+        ++cell_offsets_[GetCell(GetRow(stop.coordinates.lat), GetCol(stop.coordinates.lng)) + 1];
+    }
+    for (size_t i = 1; i < cell_offsets_.size(); ++i) {
+        cell_offsets_[i] += cell_offsets_[i - 1];
+    }
+    cell_stops_.resize(stops.size());
+    std::vector<size_t> positions(cell_offsets_.begin(), cell_offsets_.end() - 1);
+    for (const auto& stop : stops) {
+        size_t cell = GetCell(GetRow(stop.coordinates.lat), GetCol(stop.coordinates.lng));
+        cell_stops_[positions[cell]++] = &stop;
+    }
+}
+
+std::vector<StopDistance> StopSpatialIndex::FindNearest(geo::Coordinates point, size_t count) const {
+    std::vector<StopDistance> result;
+    count = std::min(count, cell_stops_.size());
+    if (count == 0) {
+        return result;
+    }
+    result.reserve(count);
+
+    auto closer = [](const StopDistance& lhs, const StopDistance& rhs) {
+        return std::tie(lhs.distance, lhs.stop->stopname) < std::tie(rhs.distance, rhs.stop->stopname);
+    };
+    auto visit_cell = [&](size_t row, size_t col) {
+        const size_t cell = GetCell(row, col);
+        for (size_t i = cell_offsets_[cell]; i < cell_offsets_[cell + 1]; ++i) {
+            StopDistance candidate{cell_stops_[i], geo::ComputeDistance(point, cell_stops_[i]->coordinates)};
+            if (result.size() < count) {
+                result.push_back(candidate);
+                std::push_heap(result.begin(), result.end(), closer);
+            } else if (closer(candidate, result.front())) {
+                std::pop_heap(result.begin(), result.end(), closer);
+                result.back() = candidate;
+                std::push_heap(result.begin(), result.end(), closer);
+            }
+        }
+    };
+
+    const size_t row = GetRow(point.lat);
+    const size_t col = GetCol(point.lng);
+    for (size_t ring = 0;; ++ring) {
+        const double bound = GetRingLowerBound(point, row, col, ring);
+        if (bound == std::numeric_limits<double>::infinity()
+            || (result.size() == count && bound > result.front().distance)) {
+            break;
+        }
+        const long long r = static_cast<long long>(ring);
+        const long long first_row = static_cast<long long>(row) - r;
+        const long long last_row = static_cast<long long>(row) + r;
+        const long long first_col = static_cast<long long>(col) - r;
+        const long long last_col = static_cast<long long>(col) + r;
+        auto in_grid = [this](long long i, long long j) {
+            return i >= 0 && j >= 0 && i < static_cast<long long>(rows_) && j < static_cast<long long>(cols_);
+        };
+        for (long long j = first_col; j <= last_col; ++j) {
+            if (in_grid(first_row, j)) {
+                visit_cell(first_row, j);
+            }
+            if (ring > 0 && in_grid(last_row, j)) {
+                visit_cell(last_row, j);
+            }
+        }
+        for (long long i = first_row + 1; i < last_row; ++i) {
+            if (in_grid(i, first_col)) {
+                visit_cell(i, first_col);
+            }
+            if (in_grid(i, last_col)) {
+                visit_cell(i, last_col);
+            }
+        }
+    }
+
+    std::sort_heap(result.begin(), result.end(), closer);
+    return result;
+}
+
+std::vector<const Stop*> StopSpatialIndex::FindInArea(const geo::Area& area) const {
+    std::vector<const Stop*> result;
+    if (cell_stops_.empty() || area.min.lat > area.max.lat || area.min.lng > area.max.lng) {
+        return result;
+    }
+    const size_t first_row = GetRow(area.min.lat);
+    const size_t last_row = GetRow(area.max.lat);
+    const size_t first_col = GetCol(area.min.lng);
+    const size_t last_col = GetCol(area.max.lng);
+    for (size_t row = first_row; row <= last_row; ++row) {
+        const size_t begin = cell_offsets_[GetCell(row, first_col)];
+        const size_t end = cell_offsets_[GetCell(row, last_col) + 1];
+        for (size_t i = begin; i < end; ++i) {
+            if (area.Contains(cell_stops_[i]->coordinates)) {
+                result.push_back(cell_stops_[i]);
+            }
+        }
+    }
+    return result;
+}
+
+size_t StopSpatialIndex::EstimateMemoryUsage() const {
+    return cell_offsets_.capacity() * sizeof(size_t) + cell_stops_.capacity() * sizeof(const Stop*);
+}
+
+size_t StopSpatialIndex::GetRow(double lat) const {
+    const double row = std::floor((lat - min_.lat) / cell_lat_);
+    return static_cast<size_t>(std::clamp(row, 0.0, static_cast<double>(rows_ - 1)));
+}
+
+size_t StopSpatialIndex::GetCol(double lng) const {
+    const double col = std::floor((lng - min_.lng) / cell_lng_);
+    return static_cast<size_t>(std::clamp(col, 0.0, static_cast<double>(cols_ - 1)));
+}
+
+size_t StopSpatialIndex::GetCell(size_t row, size_t col) const {
+    return row * cols_ + col;
+}
+
+// Нижняя оценка расстояния от point до любой остановки в кольцах сетки с номером ring и дальше.
+// Бесконечность означает, что таких колец в сетке не осталось
+double StopSpatialIndex::GetRingLowerBound(geo::Coordinates point, size_t row, size_t col, size_t ring) const {
+    if (ring == 0) {
+        return 0.0;
+    }
+    const size_t inner = ring - 1;
+    double bound = std::numeric_limits<double>::infinity();
+    if (row > inner) {
+        const double edge = min_.lat + (row - inner) * cell_lat_;
+        bound = std::min(bound, std::max(0.0, point.lat - edge) * METERS_IN_DEGREE);
+    }
+    if (row + inner + 1 < rows_) {
+        const double edge = min_.lat + (row + inner + 1) * cell_lat_;
+        bound = std::min(bound, std::max(0.0, edge - point.lat) * METERS_IN_DEGREE);
+    }
+    const double lng_factor = std::min(lng_meters_factor_,
+        METERS_IN_DEGREE * std::cos(point.lat * M_PI / 180.0) * LNG_SAFETY_FACTOR);
+    if (col > inner) {
+        const double edge = min_.lng + (col - inner) * cell_lng_;
+        bound = std::min(bound, std::max(0.0, point.lng - edge) * std::max(lng_factor, 0.0));
+    }
+    if (col + inner + 1 < cols_) {
+        const double edge = min_.lng + (col + inner + 1) * cell_lng_;
+        bound = std::min(bound, std::max(0.0, edge - point.lng) * std::max(lng_factor, 0.0));
+    }
+    return bound;
+}
+
+} // namespace transport_catalogue
\ No newline at end of file
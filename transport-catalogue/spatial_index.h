@@ -0,0 +1,46 @@
+#pragma once
+
+#include "domain.h"
+#include "geo.h"
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+namespace transport_catalogue {
+
+// Равномерная сетка над координатами остановок. Ячейки хранятся подряд
+// в одном массиве, cell_offsets_ задаёт границы каждой ячейки
+class StopSpatialIndex {
+public:
+    StopSpatialIndex() = default;
+
+    explicit StopSpatialIndex(const std::deque<Stop>& stops);
+
+    // Возвращает не более count ближайших к point остановок по возрастанию расстояния
+    std::vector<StopDistance> FindNearest(geo::Coordinates point, size_t count) const;
+
+    std::vector<const Stop*> FindInArea(const geo::Area& area) const;
+
+    size_t EstimateMemoryUsage() const;
+
+private:
+    geo::Coordinates min_{0.0, 0.0};
+    double cell_lat_ = 0.0;
+    double cell_lng_ = 0.0;
+    double lng_meters_factor_ = 0.0;
+    size_t rows_ = 0;
+    size_t cols_ = 0;
+    std::vector<size_t> cell_offsets_;
+    std::vector<const Stop*> cell_stops_;
+
+    size_t GetRow(double lat) const;
+
+    size_t GetCol(double lng) const;
+
+    size_t GetCell(size_t row, size_t col) const;
+
+    double GetRingLowerBound(geo::Coordinates point, size_t row, size_t col, size_t ring) const;
+};
+
+} // namespace transport_catalogue
\ No newline at end of file
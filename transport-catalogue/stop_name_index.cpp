@@ -0,0 +1,100 @@
+#include "stop_name_index.h"
+
+#include <algorithm>
+#include <queue>
+#include <utility>
+
+namespace transport_catalogue {
+
+StopNameIndex::StopNameIndex(const std::deque<Stop>& stops) {
+    sorted_stops_.reserve(stops.size());
+    for (const auto& stop : stops) {
+        sorted_stops_.push_back(&stop);
+    }
+    std::sort(sorted_stops_.begin(), sorted_stops_.end(), [](const Stop* lhs, const Stop* rhs) {
+        return lhs->stopname < rhs->stopname;
+    });
+
+    nodes_.push_back(TrieNode{0, 0, 0, static_cast<uint32_t>(sorted_stops_.size())});
+    std::queue<std::pair<uint32_t, size_t>> pending;
+    pending.push({0, 0});
+    while (!pending.empty()) {
+        const auto [node_id, depth] = pending.front();
+        pending.pop();
+        const uint32_t end = nodes_[node_id].end;
+        uint32_t group_begin = nodes_[node_id].begin;
+        while (group_begin < end && GetName(group_begin).size() == depth) {
+            ++group_begin;
+        }
+        nodes_[node_id].first_edge = static_cast<uint32_t>(edges_.size());
+        while (group_begin < end) {
+            const char first_char = GetName(group_begin)[depth];
+            uint32_t group_end = group_begin + 1;
+            while (group_end < end && GetName(group_end)[depth] == first_char) {
+                ++group_end;
+            }
+            const std::string_view first = GetName(group_begin);
+            const std::string_view last = GetName(group_end - 1);
+            size_t child_depth = depth + 1;
+            while (child_depth < first.size() && child_depth < last.size()
+                && first[child_depth] == last[child_depth]) {
+                ++child_depth;
+            }
+            const auto child_id = static_cast<uint32_t>(nodes_.size());
+            nodes_.push_back(TrieNode{0, 0, group_begin, group_end});
+            edges_.push_back(TrieEdge{first.substr(depth, child_depth - depth), child_id});
+            pending.push({child_id, child_depth});
+            group_begin = group_end;
+        }
+        nodes_[node_id].edge_count = static_cast<uint32_t>(edges_.size()) - nodes_[node_id].first_edge;
+    }
+}
+
+std::vector<const Stop*> StopNameIndex::FindByPrefix(std::string_view prefix, size_t count) const {
+    std::vector<const Stop*> result;
+    const TrieNode* node = FindNode(prefix);
+    if (node == nullptr) {
+        return result;
+    }
+    const size_t size = std::min<size_t>(count, node->end - node->begin);
+    result.assign(sorted_stops_.begin() + node->begin, sorted_stops_.begin() + node->begin + size);
+    return result;
+}
+
+size_t StopNameIndex::EstimateMemoryUsage() const {
+    return sorted_stops_.capacity() * sizeof(const Stop*) + nodes_.capacity() * sizeof(TrieNode)
+        + edges_.capacity() * sizeof(TrieEdge);
+}
+
+std::string_view StopNameIndex::GetName(uint32_t index) const {
+    return sorted_stops_[index]->stopname;
+}
+
+const StopNameIndex::TrieNode* StopNameIndex::FindNode(std::string_view prefix) const {
+    if (nodes_.empty()) {
+        return nullptr;
+    }
+    const TrieNode* node = &nodes_.front();
+    while (!prefix.empty()) {
+        const auto edges_begin = edges_.begin() + node->first_edge;
+        const auto edges_end = edges_begin + node->edge_count;
+        const auto edge = std::lower_bound(edges_begin, edges_end, prefix.front(),
+            [](const TrieEdge& edge, char c) {
+                return static_cast<unsigned char>(edge.label.front()) < static_cast<unsigned char>(c);
+            });
+        if (edge == edges_end || edge->label.front() != prefix.front()) {
+            return nullptr;
+        }
+        if (prefix.size() <= edge->label.size()) {
+            return edge->label.substr(0, prefix.size()) == prefix ? &nodes_[edge->child] : nullptr;
+        }
+        if (prefix.substr(0, edge->label.size()) != edge->label) {
+            return nullptr;
+        }
+        prefix.remove_prefix(edge->label.size());
+        node = &nodes_[edge->child];
+    }
+    return node;
+}
+
+} // namespace transport_catalogue
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "domain.h"
+
+#include <cstdint>
+#include <deque>
+#include <string_view>
+#include <vector>
+
+namespace transport_catalogue {
+
+// Сжатое префиксное дерево над названиями остановок. Каждый узел хранит
+// диапазон в отсортированном по названию массиве остановок, поэтому первые
+// count совпадений по префиксу выдаются без обхода поддерева
+class StopNameIndex {
+public:
+    StopNameIndex() = default;
+
+    explicit StopNameIndex(const std::deque<Stop>& stops);
+
+    std::vector<const Stop*> FindByPrefix(std::string_view prefix, size_t count) const;
+
+    size_t EstimateMemoryUsage() const;
+
+private:
+    struct TrieNode {
+        uint32_t first_edge = 0;
+        uint32_t edge_count = 0;
+        uint32_t begin = 0;
+        uint32_t end = 0;
+    };
+
+    struct TrieEdge {
+        std::string_view label;
+        uint32_t child = 0;
+    };
+
+    std::vector<const Stop*> sorted_stops_;
+    std::vector<TrieNode> nodes_;
+    std::vector<TrieEdge> edges_;
+
+    std::string_view GetName(uint32_t index) const;
+
+    const TrieNode* FindNode(std::string_view prefix) const;
+};
+
+} // namespace transport_catalogue
\ No newline at end of file
@@ -0,0 +1,273 @@
+#include "stream_reader.h"
+
+#include <stdexcept>
+
+namespace transport_catalogue {
+
+namespace json_processing {
+
+namespace {
+
+constexpr std::string_view BASE_REQUESTS = "base_requests";
+
+// Уровни вложенности внутри документа с запросами
+constexpr size_t ROOT_DEPTH = 1;
+constexpr size_t BASE_ARRAY_DEPTH = 2;
+constexpr size_t REQUEST_DEPTH = 3;
+constexpr size_t FIELD_DEPTH = 4;
+
+} // namespace
+
+StreamingReader::StreamingReader(TransportCatalogue& catalogue)
+    : catalogue_(catalogue) {
+}
+
+json::Dict StreamingReader::Read(std::istream& input) {
+    json::Parse(input, *this);
+    catalogue_.BuildIndexes();
+    return std::move(sections_);
+}
+
+uint32_t StreamingReader::GetStopId(std::string_view stopname) {
+    if (auto it = stop_ids_.find(stopname); it != stop_ids_.end()) {
+        return it->second;
+    }
+    const auto id = static_cast<uint32_t>(stops_by_id_.size());
+    stop_ids_.emplace(forward_names_.emplace_back(stopname), id);
+    stops_by_id_.push_back(nullptr);
+    return id;
+}
+
+json::Builder* StreamingReader::GetSectionBuilder() {
+    using namespace std::literals;
+    if (depth_ == 0) {
+        throw json::ParsingError("Requests document must be a dict"s);
+    }
+    if (!in_section_ && depth_ == ROOT_DEPTH && section_key_ != BASE_REQUESTS) {
+        in_section_ = true;
+    }
+    return in_section_ ? &section_ : nullptr;
+}
+
+template <typename T>
+void StreamingReader::AddSectionValue(T&& value) {
+    using namespace std::literals;
+    if (json::Builder* builder = GetSectionBuilder()) {
+        builder->Value(std::forward<T>(value));
+        if (depth_ == ROOT_DEPTH) {
+            FinishSectionValue();
+        }
+    } else if (depth_ == ROOT_DEPTH) {
+        throw json::ParsingError("base_requests must be an array"s);
+    }
+}
+
+void StreamingReader::AddStop() {
+    catalogue_.AddStop(Stop{request_.name, request_.coordinates});
+    const Stop* stop = catalogue_.GetStop(request_.name);
+    uint32_t id = 0;
+    if (auto it = stop_ids_.find(request_.name); it != stop_ids_.end()) {
+        id = it->second;
+        stops_by_id_[id] = stop;
+    } else {
+        id = static_cast<uint32_t>(stops_by_id_.size());
+        stop_ids_.emplace(stop->stopname, id);
+        stops_by_id_.push_back(stop);
+    }
+    for (const auto& [to, distance] : request_.road_distances) {
+        distances_.push_back(PendingDistance{id, to, distance});
+    }
+}
+
+void StreamingReader::FinishBaseRequest() {
+    using namespace std::literals;
+    if (request_.type == "Stop"sv) {
+        AddStop();
+    } else if (request_.type == "Bus"sv) {
+        buses_.push_back(PendingBus{std::move(request_.name), std::move(request_.stops), request_.is_roundtrip});
+    }
+}
+
+// Расстояния и маршруты добавляются после всех остановок, как и при разборе через DOM
+void StreamingReader::FinishBaseRequests() {
+    using namespace std::literals;
+    for (const auto& [from, to, distance] : distances_) {
+        if (stops_by_id_[to] != nullptr) {
+            catalogue_.AddDistance(stops_by_id_[from]->stopname, stops_by_id_[to]->stopname, distance);
+        }
+    }
+    for (auto& bus : buses_) {
+        std::vector<const Stop*> busroute;
+        busroute.reserve(bus.is_roundtrip ? bus.stops.size() : 2 * bus.stops.size());
+        for (uint32_t id : bus.stops) {
+            if (stops_by_id_[id] == nullptr) {
+                throw std::runtime_error("Bus "s + bus.name + " refers to an unknown stop"s);
+            }
+            busroute.push_back(stops_by_id_[id]);
+        }
+        if (!bus.is_roundtrip && !busroute.empty()) {
+            for (size_t i = busroute.size() - 1; i > 0; --i) {
+                busroute.push_back(busroute[i - 1]);
+            }
+        }
+        catalogue_.AddBus(Bus{std::move(bus.name), std::move(busroute), bus.is_roundtrip});
+    }
+    stop_ids_ = {};
+    stops_by_id_ = {};
+    forward_names_ = {};
+    distances_ = {};
+    buses_ = {};
+}
+
+void StreamingReader::FinishSectionValue() {
+    sections_.emplace(std::move(section_key_), section_.Build());
+    in_section_ = false;
+}
+
+void StreamingReader::StartDict() {
+    using namespace std::literals;
+    if (depth_ == 0) {
+        ++depth_;
+        return;
+    }
+    if (json::Builder* builder = GetSectionBuilder()) {
+        builder->StartDict();
+    } else if (depth_ == ROOT_DEPTH) {
+        throw json::ParsingError("base_requests must be an array"s);
+    } else if (depth_ == BASE_ARRAY_DEPTH) {
+        request_ = BaseRequest{};
+    } else if (depth_ == REQUEST_DEPTH && field_ != Field::ROAD_DISTANCES) {
+        field_ = Field::OTHER;
+    }
+    ++depth_;
+}
+
+void StreamingReader::Key(std::string_view key) {
+    using namespace std::literals;
+    if (in_section_) {
+        section_.Key(key);
+    } else if (depth_ == ROOT_DEPTH) {
+        section_key_ = key;
+    } else if (depth_ == REQUEST_DEPTH) {
+        if (key == "type"sv) {
+            field_ = Field::TYPE;
+        } else if (key == "name"sv) {
+            field_ = Field::NAME;
+        } else if (key == "latitude"sv) {
+            field_ = Field::LATITUDE;
+        } else if (key == "longitude"sv) {
+            field_ = Field::LONGITUDE;
+        } else if (key == "road_distances"sv) {
+            field_ = Field::ROAD_DISTANCES;
+        } else if (key == "stops"sv) {
+            field_ = Field::STOPS;
+        } else if (key == "is_roundtrip"sv) {
+            field_ = Field::IS_ROUNDTRIP;
+        } else {
+            field_ = Field::OTHER;
+        }
+    } else if (depth_ == FIELD_DEPTH && field_ == Field::ROAD_DISTANCES) {
+        distance_to_ = GetStopId(key);
+    }
+}
+
+void StreamingReader::EndDict() {
+    --depth_;
+    if (in_section_) {
+        section_.EndDict();
+        if (depth_ == ROOT_DEPTH) {
+            FinishSectionValue();
+        }
+    } else if (depth_ == BASE_ARRAY_DEPTH) {
+        FinishBaseRequest();
+    }
+}
+
+void StreamingReader::StartArray() {
+    using namespace std::literals;
+    if (json::Builder* builder = GetSectionBuilder()) {
+        builder->StartArray();
+    } else if (depth_ == BASE_ARRAY_DEPTH) {
+        throw json::ParsingError("Base request must be a dict"s);
+    } else if (depth_ == REQUEST_DEPTH && field_ != Field::STOPS) {
+        field_ = Field::OTHER;
+    }
+    ++depth_;
+}
+
+void StreamingReader::EndArray() {
+    --depth_;
+    if (in_section_) {
+        section_.EndArray();
+        if (depth_ == ROOT_DEPTH) {
+            FinishSectionValue();
+        }
+    } else if (depth_ == ROOT_DEPTH) {
+        FinishBaseRequests();
+    }
+}
+
+void StreamingReader::String(std::string_view value) {
+    using namespace std::literals;
+    if (in_section_ || depth_ <= ROOT_DEPTH) {
+        AddSectionValue(value);
+    } else if (depth_ == BASE_ARRAY_DEPTH) {
+        throw json::ParsingError("Base request must be a dict"s);
+    } else if (depth_ == REQUEST_DEPTH && field_ == Field::TYPE) {
+        request_.type = value;
+    } else if (depth_ == REQUEST_DEPTH && field_ == Field::NAME) {
+        request_.name = value;
+    } else if (depth_ == FIELD_DEPTH && field_ == Field::STOPS) {
+        request_.stops.push_back(GetStopId(value));
+    }
+}
+
+void StreamingReader::Int(int value) {
+    using namespace std::literals;
+    if (in_section_ || depth_ <= ROOT_DEPTH) {
+        AddSectionValue(value);
+    } else if (depth_ == BASE_ARRAY_DEPTH) {
+        throw json::ParsingError("Base request must be a dict"s);
+    } else if (depth_ == FIELD_DEPTH && field_ == Field::ROAD_DISTANCES && distance_to_) {
+        request_.road_distances.emplace_back(*distance_to_, value);
+    } else {
+        Double(value);
+    }
+}
+
+void StreamingReader::Double(double value) {
+    using namespace std::literals;
+    if (in_section_ || depth_ <= ROOT_DEPTH) {
+        AddSectionValue(value);
+    } else if (depth_ == BASE_ARRAY_DEPTH) {
+        throw json::ParsingError("Base request must be a dict"s);
+    } else if (depth_ == REQUEST_DEPTH && field_ == Field::LATITUDE) {
+        request_.coordinates.lat = value;
+    } else if (depth_ == REQUEST_DEPTH && field_ == Field::LONGITUDE) {
+        request_.coordinates.lng = value;
+    }
+}
+
+void StreamingReader::Bool(bool value) {
+    using namespace std::literals;
+    if (in_section_ || depth_ <= ROOT_DEPTH) {
+        AddSectionValue(value);
+    } else if (depth_ == BASE_ARRAY_DEPTH) {
+        throw json::ParsingError("Base request must be a dict"s);
+    } else if (depth_ == REQUEST_DEPTH && field_ == Field::IS_ROUNDTRIP) {
+        request_.is_roundtrip = value;
+    }
+}
+
+void StreamingReader::Null() {
+    using namespace std::literals;
+    if (in_section_ || depth_ <= ROOT_DEPTH) {
+        AddSectionValue(nullptr);
+    } else if (depth_ == BASE_ARRAY_DEPTH) {
+        throw json::ParsingError("Base request must be a dict"s);
+    }
+}
+
+} // namespace json_processing
+
+} // namespace transport_catalogue
\ No newline at end of file
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "json.h"
+#include "json_builder.h"
+#include "transport_catalogue.h"
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace transport_catalogue {
+
+namespace json_processing {
+
+// Заполняет справочник из base_requests по мере разбора входного потока, не строя DOM.
+// Названия остановок получают номера при первом упоминании, поэтому маршруты и расстояния
+// до конца разбора хранятся компактно. Остальные разделы документа собираются в DOM как есть
+class StreamingReader final : private json::Handler {
+public:
+    explicit StreamingReader(TransportCatalogue& catalogue);
+
+    // Возвращает все разделы документа, кроме base_requests
+    json::Dict Read(std::istream& input);
+
+private:
+    enum class Field {
+        OTHER,
+        TYPE,
+        NAME,
+        LATITUDE,
+        LONGITUDE,
+        ROAD_DISTANCES,
+        STOPS,
+        IS_ROUNDTRIP
+    };
+
+    struct PendingDistance {
+        uint32_t from;
+        uint32_t to;
+        int distance;
+    };
+
+    struct PendingBus {
+        std::string name;
+        std::vector<uint32_t> stops;
+        bool is_roundtrip;
+    };
+
+    // Поля разбираемого элемента base_requests
+    struct BaseRequest {
+        std::string type;
+        std::string name;
+        geo::Coordinates coordinates{0.0, 0.0};
+        std::vector<std::pair<uint32_t, int>> road_distances;
+        std::vector<uint32_t> stops;
+        bool is_roundtrip = false;
+    };
+
+    TransportCatalogue& catalogue_;
+    size_t depth_ = 0;
+    Field field_ = Field::OTHER;
+    BaseRequest request_;
+    std::optional<uint32_t> distance_to_;
+
+    std::unordered_map<std::string_view, uint32_t> stop_ids_;
+    std::vector<const Stop*> stops_by_id_;
+    // Названия остановок, упомянутых раньше своего описания
+    std::deque<std::string> forward_names_;
+    std::vector<PendingDistance> distances_;
+    std::vector<PendingBus> buses_;
+
+    std::string section_key_;
+    // Построитель переиспользуется для всех разделов, кроме base_requests
+    json::Builder section_;
+    bool in_section_ = false;
+    json::Dict sections_;
+
+    uint32_t GetStopId(std::string_view stopname);
+
+    // Возвращает построитель DOM, если событие относится не к base_requests
+    json::Builder* GetSectionBuilder();
+
+    template <typename T>
+    void AddSectionValue(T&& value);
+
+    void AddStop();
+
+    void FinishBaseRequest();
+
+    void FinishBaseRequests();
+
+    void FinishSectionValue();
+
+    void StartDict() override;
+
+    void Key(std::string_view key) override;
+
+    void EndDict() override;
+
+    void StartArray() override;
+
+    void EndArray() override;
+
+    void String(std::string_view value) override;
+
+    void Int(int value) override;
+
+    void Double(double value) override;
+
+    void Bool(bool value) override;
+
+    void Null() override;
+};
+
+} // namespace json_processing
+
+} // namespace transport_catalogue
\ No newline at end of file
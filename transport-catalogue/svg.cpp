@@ -51,7 +51,7 @@ void Object::Render(const RenderContext& context) const {
     // Делегируем вывод тега своим подклассам
     RenderObject(context);
 
-    context.out << std::endl;
+    context.out.put('\n');
 }
 
 // ---------- Circle ------------------
@@ -169,12 +169,16 @@ void Document::AddPtr(std::unique_ptr<Object>&& obj) {
 }
 
 void Document::Render(std::ostream& out) const {
-    out << "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>"sv << std::endl;
-    out << "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">"sv << std::endl;
+    out << "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\n"sv;
+    out << "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">\n"sv;
     for (auto& object : objects_) {
         object->Render(RenderContext{out, 2, 2});
     }
     out << "</svg>"sv;
 }
 
+void Document::Clear() {
+    objects_.clear();
+}
+
 }  // namespace svg
\ No newline at end of file
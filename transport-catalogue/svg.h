@@ -18,12 +18,18 @@ struct Point {
     }
     double x = 0;
     double y = 0;
+    bool operator==(const Point& other) const {
+        return x == other.x && y == other.y;
+    }
 };
 
 struct Rgb {
     uint8_t red = 0;
     uint8_t green = 0;
     uint8_t blue = 0;
+    bool operator==(const Rgb& other) const {
+        return red == other.red && green == other.green && blue == other.blue;
+    }
 };
 
 struct Rgba {
@@ -31,6 +37,9 @@ struct Rgba {
     uint8_t green = 0;
     uint8_t blue = 0;
     double opacity = 1.0;
+    bool operator==(const Rgba& other) const {
+        return red == other.red && green == other.green && blue == other.blue && opacity == other.opacity;
+    }
 };
 
 using Color = std::variant<std::monostate, std::string, Rgb, Rgba>;
@@ -283,6 +292,9 @@ public:
 
     // Выводит в ostream svg-представление документа
     void Render(std::ostream& out) const;
+
+    // Удаляет из документа все объекты
+    void Clear();
 };
 
 class Drawable {
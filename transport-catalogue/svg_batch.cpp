@@ -0,0 +1,378 @@
+#include "svg_batch.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <sstream>
+
+namespace svg {
+
+using namespace std::literals;
+
+namespace {
+
+// Столько же значащих цифр выводит std::ostream по умолчанию
+constexpr int DOUBLE_PRECISION = 6;
+constexpr std::string_view INDENT = "  "sv;
+
+void AppendNumber(std::string& out, double value) {
+    char chars[32];
+    const auto result = std::to_chars(chars, chars + sizeof(chars), value, std::chars_format::general, DOUBLE_PRECISION);
+    out.append(chars, result.ptr);
+}
+
+void AppendNumber(std::string& out, uint32_t value) {
+    char chars[16];
+    const auto result = std::to_chars(chars, chars + sizeof(chars), value);
+    out.append(chars, result.ptr);
+}
+
+void AppendPoint(std::string& out, Point point) {
+    AppendNumber(out, point.x);
+    out += ',';
+    AppendNumber(out, point.y);
+}
+
+// Выводит value / 10^precision без лишних нулей. Ведущий ноль опускается: ".5", "-.25"
+void AppendFixed(std::string& out, int64_t value, int precision) {
+    if (value < 0) {
+        out += '-';
+    }
+    uint64_t magnitude = value < 0 ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+    char digits[32];
+    const auto result = std::to_chars(digits, digits + sizeof(digits), magnitude);
+    std::string_view text(digits, result.ptr - digits);
+    const auto length = static_cast<int>(text.size());
+    if (length > precision) {
+        out += text.substr(0, length - precision);
+        text.remove_prefix(length - precision);
+    } else if (magnitude == 0) {
+        out += '0';
+        return;
+    }
+    while (!text.empty() && text.back() == '0') {
+        text.remove_suffix(1);
+    }
+    if (!text.empty()) {
+        out += '.';
+        out.append(static_cast<size_t>(std::max(0, precision - length)), '0');
+        out += text;
+    }
+}
+
+// Символы без экранирования копируются целыми отрезками
+void AppendEscaped(std::string& out, std::string_view data) {
+    size_t plain_begin = 0;
+    for (size_t i = 0; i < data.size(); ++i) {
+        std::string_view escaped;
+        switch (data[i]) {
+            case '"':
+                escaped = "&quot;"sv;
+                break;
+            case '\'':
+                escaped = "&apos;"sv;
+                break;
+            case '<':
+                escaped = "&lt;"sv;
+                break;
+            case '>':
+                escaped = "&gt;"sv;
+                break;
+            case '&':
+                escaped = "&amp;"sv;
+                break;
+            default:
+                continue;
+        }
+        out.append(data, plain_begin, i - plain_begin);
+        out += escaped;
+        plain_begin = i + 1;
+    }
+    out.append(data, plain_begin, data.size() - plain_begin);
+}
+
+// Один атрибут в двух видах: для элемента и для объявления CSS
+template <typename Value>
+void AppendProperty(std::ostream& attributes, std::ostream& declarations, std::string_view name, const Value& value) {
+    attributes << ' ' << name << "=\""sv << value << '"';
+    declarations << name << ':' << value << ';';
+}
+
+} // namespace
+
+BatchDocument::BatchDocument(StyleMode mode, std::optional<int> path_precision)
+    : mode_(mode), path_precision_(path_precision) {
+    if (path_precision_) {
+        path_precision_ = std::clamp(*path_precision_, 0, MAX_PATH_PRECISION);
+    }
+}
+
+BatchDocument::AttributesId BatchDocument::AddStyle(const Style& style) {
+    std::ostringstream attributes;
+    std::ostringstream declarations;
+    if (style.fill_color) {
+        AppendProperty(attributes, declarations, "fill"sv, *style.fill_color);
+    }
+    if (style.stroke_color) {
+        AppendProperty(attributes, declarations, "stroke"sv, *style.stroke_color);
+    }
+    if (style.stroke_width) {
+        AppendProperty(attributes, declarations, "stroke-width"sv, *style.stroke_width);
+    }
+    if (style.line_cap) {
+        AppendProperty(attributes, declarations, "stroke-linecap"sv, *style.line_cap);
+    }
+    if (style.line_join) {
+        AppendProperty(attributes, declarations, "stroke-linejoin"sv, *style.line_join);
+    }
+    return InternAttributes(attributes.str(), declarations.str());
+}
+
+BatchDocument::AttributesId BatchDocument::AddFont(std::string_view font_family, std::string_view font_weight) {
+    std::ostringstream attributes;
+    std::ostringstream declarations;
+    if (!font_family.empty()) {
+        AppendProperty(attributes, declarations, "font-family"sv, font_family);
+    }
+    if (!font_weight.empty()) {
+        AppendProperty(attributes, declarations, "font-weight"sv, font_weight);
+    }
+    return InternAttributes(attributes.str(), declarations.str());
+}
+
+void BatchDocument::AddCircle(Point center, double radius, AttributesId style) {
+    if (mode_ == StyleMode::CLASSES) {
+        style = InternClass(declarations_[style]);
+    }
+    elements_.push_back(Element{ElementType::CIRCLE, static_cast<uint32_t>(circles_.size())});
+    circles_.push_back(CircleData{center, radius, style});
+}
+
+void BatchDocument::StartPolyline(AttributesId style) {
+    if (mode_ == StyleMode::CLASSES) {
+        style = InternClass(declarations_[style]);
+    }
+    const auto begin = static_cast<uint32_t>(points_.size());
+    elements_.push_back(Element{ElementType::POLYLINE, static_cast<uint32_t>(polylines_.size())});
+    polylines_.push_back(PolylineData{begin, begin, style});
+}
+
+void BatchDocument::AddPoint(Point point) {
+    points_.push_back(point);
+    polylines_.back().points_end = static_cast<uint32_t>(points_.size());
+}
+
+void BatchDocument::AddText(Point pos, Point offset, uint32_t font_size, AttributesId font, std::string_view data,
+        AttributesId style) {
+    if (mode_ == StyleMode::CLASSES) {
+        std::string declarations = declarations_[style] + declarations_[font] + "font-size:"s;
+        AppendNumber(declarations, font_size);
+        // В CSS размер шрифта без единиц не допускается
+        declarations += "px"sv;
+        style = InternClass(std::move(declarations));
+    }
+    elements_.push_back(Element{ElementType::TEXT, static_cast<uint32_t>(texts_.size())});
+    texts_.push_back(TextData{pos, offset, font_size, font, style,
+        static_cast<uint32_t>(text_data_.size()), static_cast<uint32_t>(data.size())});
+    text_data_ += data;
+}
+
+void BatchDocument::Render(std::string& out) const {
+    out.reserve(out.size() + EstimateSize());
+    RenderHeader(out);
+    for (const Element& element : elements_) {
+        RenderElement(element, out);
+    }
+    RenderFooter(out);
+}
+
+void BatchDocument::RenderElements(size_t begin, size_t end, std::string& out) const {
+    for (size_t i = begin; i < end; ++i) {
+        RenderElement(elements_[i], out);
+    }
+}
+
+void BatchDocument::Render(std::ostream& out) const {
+    std::string buffer;
+    Render(buffer);
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+}
+
+void BatchDocument::Clear() {
+    elements_.clear();
+    circles_.clear();
+    polylines_.clear();
+    points_.clear();
+    texts_.clear();
+    text_data_.clear();
+}
+
+size_t BatchDocument::GetElementCount() const {
+    return elements_.size();
+}
+
+BatchDocument::AttributesId BatchDocument::InternAttributes(std::string attributes, std::string declarations) {
+    const auto [it, inserted] = attribute_ids_.try_emplace(attributes, static_cast<AttributesId>(attributes_.size()));
+    if (inserted) {
+        attributes_.push_back(std::move(attributes));
+        declarations_.push_back(std::move(declarations));
+    }
+    return it->second;
+}
+
+uint32_t BatchDocument::InternClass(std::string declarations) {
+    const auto [it, inserted] = class_ids_.try_emplace(declarations, static_cast<uint32_t>(classes_.size()));
+    if (inserted) {
+        classes_.push_back(std::move(declarations));
+    }
+    return it->second;
+}
+
+void BatchDocument::RenderHeader(std::string& out) const {
+    out += "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\n"sv;
+    out += "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">\n"sv;
+    if (mode_ != StyleMode::CLASSES) {
+        return;
+    }
+    out += INDENT;
+    out += "<style>"sv;
+    for (uint32_t class_id = 0; class_id < classes_.size(); ++class_id) {
+        out += ".c"sv;
+        AppendNumber(out, class_id);
+        out += '{';
+        AppendEscaped(out, classes_[class_id]);
+        out += '}';
+    }
+    out += "</style>\n"sv;
+}
+
+// В режиме INLINE на месте класса выводятся атрибуты стиля
+void BatchDocument::RenderClass(uint32_t class_id, std::string& out) const {
+    if (mode_ == StyleMode::CLASSES) {
+        out += " class=\"c"sv;
+        AppendNumber(out, class_id);
+        out += '"';
+    } else {
+        out += attributes_[class_id];
+    }
+}
+
+void BatchDocument::RenderFooter(std::string& out) {
+    out += "</svg>"sv;
+}
+
+void BatchDocument::RenderElement(const Element& element, std::string& out) const {
+    out += INDENT;
+    switch (element.type) {
+        case ElementType::CIRCLE:
+            RenderCircle(circles_[element.index], out);
+            break;
+        case ElementType::POLYLINE:
+            RenderPolyline(polylines_[element.index], out);
+            break;
+        case ElementType::TEXT:
+            RenderText(texts_[element.index], out);
+            break;
+    }
+    out += '\n';
+}
+
+void BatchDocument::RenderCircle(const CircleData& circle, std::string& out) const {
+    out += "<circle cx=\""sv;
+    AppendNumber(out, circle.center.x);
+    out += "\" cy=\""sv;
+    AppendNumber(out, circle.center.y);
+    out += "\" r=\""sv;
+    AppendNumber(out, circle.radius);
+    out += '"';
+    RenderClass(circle.style, out);
+    out += "/>"sv;
+}
+
+void BatchDocument::RenderPolyline(const PolylineData& polyline, std::string& out) const {
+    if (path_precision_) {
+        RenderPath(polyline, out);
+        return;
+    }
+    out += "<polyline points=\""sv;
+    for (uint32_t i = polyline.points_begin; i < polyline.points_end; ++i) {
+        if (i != polyline.points_begin) {
+            out += ' ';
+        }
+        AppendPoint(out, points_[i]);
+    }
+    out += '"';
+    RenderClass(polyline.style, out);
+    out += "/>"sv;
+}
+
+// Вершины округляются до целого числа единиц 10^-precision, и смещения считаются
+// между округлёнными вершинами, поэтому ошибка округления не накапливается
+void BatchDocument::RenderPath(const PolylineData& polyline, std::string& out) const {
+    const int precision = *path_precision_;
+    const double scale = std::pow(10.0, precision);
+    int64_t previous_x = 0;
+    int64_t previous_y = 0;
+    // Минус сам отделяет число от предыдущего, а после команды разделитель не нужен
+    auto append_coordinate = [&out, precision](int64_t value, bool after_command) {
+        if (value >= 0 && !after_command) {
+            out += ' ';
+        }
+        AppendFixed(out, value, precision);
+    };
+    out += "<path d=\""sv;
+    for (uint32_t i = polyline.points_begin; i < polyline.points_end; ++i) {
+        const int64_t x = std::llround(points_[i].x * scale);
+        const int64_t y = std::llround(points_[i].y * scale);
+        if (i == polyline.points_begin) {
+            out += 'M';
+            append_coordinate(x, true);
+            append_coordinate(y, false);
+        } else {
+            const bool is_first_line = i == polyline.points_begin + 1;
+            if (is_first_line) {
+                out += 'l';
+            }
+            append_coordinate(x - previous_x, is_first_line);
+            append_coordinate(y - previous_y, false);
+        }
+        previous_x = x;
+        previous_y = y;
+    }
+    out += '"';
+    RenderClass(polyline.style, out);
+    out += "/>"sv;
+}
+
+void BatchDocument::RenderText(const TextData& text, std::string& out) const {
+    out += "<text"sv;
+    RenderClass(text.style, out);
+    out += " x=\""sv;
+    AppendNumber(out, text.pos.x);
+    out += "\" y=\""sv;
+    AppendNumber(out, text.pos.y);
+    out += "\" dx=\""sv;
+    AppendNumber(out, text.offset.x);
+    out += "\" dy=\""sv;
+    AppendNumber(out, text.offset.y);
+    out += '"';
+    // Шрифт и его размер входят в класс текста
+    if (mode_ != StyleMode::CLASSES) {
+        out += " font-size=\""sv;
+        AppendNumber(out, text.font_size);
+        out += '"';
+        out += attributes_[text.font];
+    }
+    out += '>';
+    AppendEscaped(out, std::string_view(text_data_).substr(text.data_begin, text.data_size));
+    out += "</text>"sv;
+}
+
+// Приблизительный размер вывода, чтобы выделить буфер один раз
+size_t BatchDocument::EstimateSize() const {
+    constexpr size_t ELEMENT_SIZE = 160;
+    constexpr size_t POINT_SIZE = 20;
+    return elements_.size() * ELEMENT_SIZE + points_.size() * POINT_SIZE + text_data_.size();
+}
+
+} // namespace svg
\ No newline at end of file
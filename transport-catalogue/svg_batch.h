@@ -0,0 +1,177 @@
+#pragma once
+
+#include "svg.h"
+
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace svg {
+
+// Атрибуты заливки и обводки, общие для элементов одного вида
+struct Style {
+    std::optional<Color> fill_color = std::nullopt;
+    std::optional<Color> stroke_color = std::nullopt;
+    std::optional<double> stroke_width = std::nullopt;
+    std::optional<StrokeLineCap> line_cap = std::nullopt;
+    std::optional<StrokeLineJoin> line_join = std::nullopt;
+};
+
+// Способ вывода стилей элементов
+enum class StyleMode {
+    // Атрибуты у каждого элемента, как в svg::Document
+    INLINE,
+    // Блок <style> с классом на каждое сочетание стиля, шрифта и размера шрифта.
+    // Элементы ссылаются только на класс
+    CLASSES
+};
+
+/*
+ * SVG-документ, в котором элементы хранятся в непрерывных массивах по типам, а не
+ * как отдельные объекты с виртуальным выводом. Стили и шрифты выводятся в текст один раз
+ * при добавлении и затем копируются в вывод целиком. В режиме INLINE вывод совпадает
+ * с svg::Document с теми же элементами
+ */
+class BatchDocument {
+public:
+    using AttributesId = uint32_t;
+
+    // Если задано path_precision, ломаные выводятся элементами <path> с относительными
+    // координатами, округлёнными до path_precision знаков после запятой
+    explicit BatchDocument(StyleMode mode = StyleMode::INLINE, std::optional<int> path_precision = std::nullopt);
+
+    // Возвращают номер готовой строки атрибутов. Одинаковые строки хранятся один раз
+    AttributesId AddStyle(const Style& style);
+
+    AttributesId AddFont(std::string_view font_family, std::string_view font_weight);
+
+    void AddCircle(Point center, double radius, AttributesId style);
+
+    // Начинает ломаную, её вершины добавляются через AddPoint
+    void StartPolyline(AttributesId style);
+
+    void AddPoint(Point point);
+
+    void AddText(Point pos, Point offset, uint32_t font_size, AttributesId font, std::string_view data,
+        AttributesId style);
+
+    // Дописывает svg-представление документа в конец out
+    void Render(std::string& out) const;
+
+    void Render(std::ostream& out) const;
+
+    // Документ можно выводить по частям, в том числе в разных потоках: заголовок, элементы
+    // с номерами [begin, end) в порядке добавления и окончание, склеенные по порядку,
+    // совпадают с выводом Render
+    void RenderHeader(std::string& out) const;
+
+    void RenderElements(size_t begin, size_t end, std::string& out) const;
+
+    static void RenderFooter(std::string& out);
+
+    // Выводит документ порциями примерно по CHUNK_SIZE байт, передавая каждую в chunk(std::string_view)
+    template <typename Chunk>
+    void RenderChunks(Chunk chunk) const;
+
+    // Удаляет элементы, сохраняя стили и шрифты
+    void Clear();
+
+    size_t GetElementCount() const;
+
+private:
+    static constexpr size_t CHUNK_SIZE = 1 << 16;
+    static constexpr int MAX_PATH_PRECISION = 9;
+
+    enum class ElementType : uint8_t {
+        CIRCLE,
+        POLYLINE,
+        TEXT
+    };
+
+    struct Element {
+        ElementType type;
+        uint32_t index;
+    };
+
+    // В режиме CLASSES поле style хранит номер класса
+    struct CircleData {
+        Point center;
+        double radius;
+        AttributesId style;
+    };
+
+    struct PolylineData {
+        uint32_t points_begin;
+        uint32_t points_end;
+        AttributesId style;
+    };
+
+    struct TextData {
+        Point pos;
+        Point offset;
+        uint32_t font_size;
+        AttributesId font;
+        AttributesId style;
+        uint32_t data_begin;
+        uint32_t data_size;
+    };
+
+    StyleMode mode_;
+    std::optional<int> path_precision_;
+    std::vector<std::string> attributes_;
+    // Те же атрибуты в виде объявлений CSS, по номерам attributes_
+    std::vector<std::string> declarations_;
+    std::unordered_map<std::string, AttributesId> attribute_ids_;
+    // Объявления CSS каждого класса
+    std::vector<std::string> classes_;
+    std::unordered_map<std::string, uint32_t> class_ids_;
+
+    // Порядок вывода элементов
+    std::vector<Element> elements_;
+    std::vector<CircleData> circles_;
+    std::vector<PolylineData> polylines_;
+    std::vector<Point> points_;
+    std::vector<TextData> texts_;
+    // Содержимое всех текстов подряд
+    std::string text_data_;
+
+    AttributesId InternAttributes(std::string attributes, std::string declarations);
+
+    uint32_t InternClass(std::string declarations);
+
+    void RenderClass(uint32_t class_id, std::string& out) const;
+
+    void RenderElement(const Element& element, std::string& out) const;
+
+    void RenderCircle(const CircleData& circle, std::string& out) const;
+
+    void RenderPolyline(const PolylineData& polyline, std::string& out) const;
+
+    void RenderPath(const PolylineData& polyline, std::string& out) const;
+
+    void RenderText(const TextData& text, std::string& out) const;
+
+    size_t EstimateSize() const;
+};
+
+template <typename Chunk>
+void BatchDocument::RenderChunks(Chunk chunk) const {
+    std::string buffer;
+    buffer.reserve(CHUNK_SIZE * 2);
+    RenderHeader(buffer);
+    for (const Element& element : elements_) {
+        RenderElement(element, buffer);
+        if (buffer.size() >= CHUNK_SIZE) {
+            chunk(std::string_view(buffer));
+            buffer.clear();
+        }
+    }
+    RenderFooter(buffer);
+    chunk(std::string_view(buffer));
+}
+
+} // namespace svg
\ No newline at end of file
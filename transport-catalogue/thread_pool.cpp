@@ -0,0 +1,145 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <exception>
+
+namespace {
+
+// Пул и номер очереди потока, который сейчас выполняет задачу
+thread_local const ThreadPool* current_pool = nullptr;
+thread_local size_t current_queue = 0;
+
+} // namespace
+
+ThreadPool::ThreadPool(size_t thread_count) {
+    thread_count = std::max<size_t>(thread_count, 1);
+    queues_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+        queues_.push_back(std::make_unique<WorkQueue>());
+    }
+    workers_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+        workers_.emplace_back([this, i] {
+            RunWorker(i);
+        });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard guard(mutex_);
+        stop_requested_ = true;
+    }
+    has_tasks_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& task) {
+    struct State {
+        std::atomic<size_t> next = 0;
+        std::mutex mutex;
+        std::condition_variable finished;
+        size_t done = 0;
+        std::exception_ptr error;
+    };
+    // Помощник может начаться уже после возврата, тогда он не найдёт свободных частей
+    // и не обратится к task
+    auto state = std::make_shared<State>();
+    auto run = [state, count, &task] {
+        for (size_t i = state->next++; i < count; i = state->next++) {
+            std::exception_ptr error;
+            try {
+                task(i);
+            } catch (...) {
+                error = std::current_exception();
+            }
+            std::lock_guard guard(state->mutex);
+            if (error && !state->error) {
+                state->error = error;
+            }
+            if (++state->done == count) {
+                state->finished.notify_all();
+            }
+        }
+    };
+    const size_t helper_count = std::min(GetThreadCount(), count > 0 ? count - 1 : 0);
+    for (size_t i = 0; i < helper_count; ++i) {
+        Enqueue(run);
+    }
+    run();
+    std::unique_lock lock(state->mutex);
+    state->finished.wait(lock, [&state, count] {
+        return state->done == count;
+    });
+    if (state->error) {
+        std::rethrow_exception(state->error);
+    }
+}
+
+size_t ThreadPool::GetThreadCount() const {
+    return workers_.size();
+}
+
+// Задачи, поставленные из потока пула, попадают в его собственную очередь,
+// остальные распределяются по очередям по кругу
+void ThreadPool::Enqueue(std::function<void()> task) {
+    const size_t index = current_pool == this
+        ? current_queue
+        : next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+    {
+        std::lock_guard guard(queues_[index]->mutex);
+        queues_[index]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard guard(mutex_);
+        ++pending_;
+    }
+    has_tasks_.notify_one();
+}
+
+bool ThreadPool::TryPop(size_t index, std::function<void()>& task) {
+    {
+        WorkQueue& own = *queues_[index];
+        std::lock_guard guard(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    for (size_t i = 1; i < queues_.size(); ++i) {
+        WorkQueue& other = *queues_[(index + i) % queues_.size()];
+        std::lock_guard guard(other.mutex);
+        if (!other.tasks.empty()) {
+            task = std::move(other.tasks.front());
+            other.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::RunWorker(size_t index) {
+    current_pool = this;
+    current_queue = index;
+    while (true) {
+        {
+            std::unique_lock lock(mutex_);
+            has_tasks_.wait(lock, [this] {
+                return stop_requested_ || pending_ > 0;
+            });
+            if (pending_ == 0) {
+                return;
+            }
+            // Задача уже лежит в одной из очередей, поток резервирует её за собой
+            --pending_;
+        }
+        std::function<void()> task;
+        while (!TryPop(index, task)) {
+            std::this_thread::yield();
+        }
+        task();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Пул потоков с очередью задач у каждого потока. Свободный поток забирает задачи
+// из чужих очередей. Результат задачи возвращается через std::future
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t thread_count = std::thread::hardware_concurrency());
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Дожидается выполнения всех поставленных задач
+    ~ThreadPool();
+
+    template <typename Task>
+    auto Submit(Task task) -> std::future<std::invoke_result_t<Task>> {
+        using Result = std::invoke_result_t<Task>;
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(std::move(task));
+        std::future<Result> result = packaged->get_future();
+        Enqueue([packaged] {
+            (*packaged)();
+        });
+        return result;
+    }
+
+    // Выполняет task(i) для каждого i от 0 до count. Части выполняет и вызывающий поток,
+    // а возврат ждёт только начатые части, поэтому вызывать можно и из задач самого пула.
+    // Первое исключение из task передаётся вызывающему
+    void ParallelFor(size_t count, const std::function<void(size_t)>& task);
+
+    size_t GetThreadCount() const;
+
+private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkQueue>> queues_;
+    std::vector<std::thread> workers_;
+    std::atomic<size_t> next_queue_ = 0;
+    std::mutex mutex_;
+    std::condition_variable has_tasks_;
+    // Число задач, ещё не взятых ни одним потоком
+    size_t pending_ = 0;
+    bool stop_requested_ = false;
+
+    void Enqueue(std::function<void()> task);
+
+    // Снимает задачу с конца своей очереди, а если она пуста, крадёт из начала чужой
+    bool TryPop(size_t index, std::function<void()>& task);
+
+    void RunWorker(size_t index);
+};
\ No newline at end of file
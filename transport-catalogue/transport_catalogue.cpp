@@ -7,17 +7,51 @@
 
 namespace transport_catalogue {
 
+TransportCatalogue::TransportCatalogue(const TransportCatalogue& other) {
+    for (const auto& stop : other.stops_) {
+        AddStop(stop);
+    }
+    for (const auto& [stops, distance] : other.stops_to_distances_) {
+        AddDistance(stops.first->stopname, stops.second->stopname, distance);
+    }
+    for (const auto& bus : other.buses_) {
+        Bus copy{bus.busname, {}, bus.is_roundtrip};
+        copy.busroute.reserve(bus.busroute.size());
+        for (const Stop* stop : bus.busroute) {
+            copy.busroute.push_back(GetStop(stop->stopname));
+        }
+        AddBus(std::move(copy));
+    }
+}
+
 void TransportCatalogue::AddStop(Stop stop) {
+    if (auto it = stopname_to_stop_.find(stop.stopname); it != stopname_to_stop_.end()) {
+        it->second->coordinates = stop.coordinates;
+        return;
+    }
+    stop.id = stops_.size();
     stops_.push_back(std::move(stop));
     std::string_view key = std::string_view(stops_[stops_.size() - 1].stopname);
-    const Stop* adr = &(stops_.back());
+    Stop* adr = &(stops_.back());
     stopname_to_stop_[key] = adr;
 }
 
 void TransportCatalogue::AddBus(Bus bus) {
+    if (auto it = busname_to_bus_.find(bus.busname); it != busname_to_bus_.end()) {
+        Bus* existing = it->second;
+        for (const Stop* stop : existing->busroute) {
+            stopname_to_buses_[stop].erase(existing->busname);
+        }
+        existing->busroute = std::move(bus.busroute);
+        existing->is_roundtrip = bus.is_roundtrip;
+        for (const Stop* stop : existing->busroute) {
+            stopname_to_buses_[stop].insert(existing->busname);
+        }
+        return;
+    }
     buses_.push_back(std::move(bus));
     std::string_view key = std::string_view(buses_[buses_.size() - 1].busname);
-    const Bus* adr = &(buses_.back());
+    Bus* adr = &(buses_.back());
     busname_to_bus_[key] = adr;
     for (const Stop* stop : buses_.back().busroute) {
         stopname_to_buses_[stop].insert(buses_.back().busname);
@@ -117,6 +151,20 @@ std::vector<geo::Coordinates> TransportCatalogue::GetAllCoordinates() const {
     return result;
 }
 
+StopCoordinates TransportCatalogue::GetStopCoordinates() const {
+    StopCoordinates result;
+    result.lats.reserve(stops_.size());
+    result.lngs.reserve(stops_.size());
+    result.in_routes.reserve(stops_.size());
+    for (const auto& stop : stops_) {
+        result.lats.push_back(stop.coordinates.lat);
+        result.lngs.push_back(stop.coordinates.lng);
+        const auto it = stopname_to_buses_.find(&stop);
+        result.in_routes.push_back(it != stopname_to_buses_.end() && !it->second.empty());
+    }
+    return result;
+}
+
 std::deque<Bus> TransportCatalogue::GetAllBuses() const {
     std::deque<Bus> result = buses_;
     std::sort(result.begin(), result.end(), [](Bus lhs, Bus rhs) {
@@ -142,4 +190,60 @@ std::deque<Stop> TransportCatalogue::GetAllStopsInRoutes() const {
     return result;
 }
 
+void TransportCatalogue::BuildIndexes() {
+    spatial_index_ = StopSpatialIndex(stops_);
+    name_index_ = StopNameIndex(stops_);
+}
+
+std::vector<StopDistance> TransportCatalogue::GetNearestStops(geo::Coordinates point, size_t count) const {
+    return spatial_index_.FindNearest(point, count);
+}
+
+AreaInfo TransportCatalogue::GetStopsInArea(const geo::Area& area) const {
+    AreaInfo result;
+    for (const Stop* stop : spatial_index_.FindInArea(area)) {
+        result.stops.push_back(stop->stopname);
+        if (auto it = stopname_to_buses_.find(stop); it != stopname_to_buses_.end()) {
+            result.buses.insert(it->second.begin(), it->second.end());
+        }
+    }
+    std::sort(result.stops.begin(), result.stops.end());
+    return result;
+}
+
+std::vector<std::string> TransportCatalogue::FindStopsByPrefix(std::string_view prefix, size_t count) const {
+    std::vector<std::string> result;
+    for (const Stop* stop : name_index_.FindByPrefix(prefix, count)) {
+        result.push_back(stop->stopname);
+    }
+    return result;
+}
+
+size_t TransportCatalogue::EstimateMemoryUsage() const {
+    constexpr size_t hash_node_overhead = 2 * sizeof(void*);
+    constexpr size_t tree_node_overhead = 4 * sizeof(void*);
+    size_t result = sizeof(*this);
+    for (const auto& stop : stops_) {
+        result += sizeof(Stop) + stop.stopname.capacity();
+    }
+    for (const auto& bus : buses_) {
+        result += sizeof(Bus) + bus.busname.capacity() + bus.busroute.capacity() * sizeof(const Stop*);
+    }
+    result += stopname_to_stop_.size() * (sizeof(std::pair<std::string_view, Stop*>) + hash_node_overhead)
+        + stopname_to_stop_.bucket_count() * sizeof(void*);
+    result += busname_to_bus_.size() * (sizeof(std::pair<std::string_view, Bus*>) + hash_node_overhead)
+        + busname_to_bus_.bucket_count() * sizeof(void*);
+    for (const auto& [stop, buses] : stopname_to_buses_) {
+        result += sizeof(std::pair<const Stop*, std::set<std::string>>) + hash_node_overhead;
+        for (const auto& bus : buses) {
+            result += sizeof(std::string) + bus.capacity() + tree_node_overhead;
+        }
+    }
+    result += stopname_to_buses_.bucket_count() * sizeof(void*);
+    result += stops_to_distances_.size() * (sizeof(DistancesContainer::value_type) + hash_node_overhead)
+        + stops_to_distances_.bucket_count() * sizeof(void*);
+    result += spatial_index_.EstimateMemoryUsage() + name_index_.EstimateMemoryUsage();
+    return result;
+}
+
 }
\ No newline at end of file
@@ -10,11 +10,25 @@
 #include <vector>
 
 #include "domain.h"
+#include "spatial_index.h"
+#include "stop_name_index.h"
 
 namespace transport_catalogue {
 
 class TransportCatalogue {
 public:
+	TransportCatalogue() = default;
+
+	// Копия не разделяет данных с оригиналом. Индексы копии строятся заново вызовом BuildIndexes
+	TransportCatalogue(const TransportCatalogue& other);
+
+	TransportCatalogue(TransportCatalogue&& other) = default;
+
+	TransportCatalogue& operator=(const TransportCatalogue& other) = delete;
+
+	TransportCatalogue& operator=(TransportCatalogue&& other) = default;
+
+	// Повторное добавление остановки или автобуса с тем же названием обновляет их
 	void AddStop(Stop stop);
 
 	void AddBus(Bus bus);
@@ -36,19 +50,35 @@ public:
 	
 	std::vector<geo::Coordinates> GetAllCoordinates() const;
 
+	// Координаты всех остановок, индекс в массивах совпадает с Stop::id
+	StopCoordinates GetStopCoordinates() const;
+
 	std::deque<Bus> GetAllBuses() const;
 
 	std::deque<Stop> GetAllStops() const;
 
 	std::deque<Stop> GetAllStopsInRoutes() const;
 
+	void BuildIndexes();
+
+	std::vector<StopDistance> GetNearestStops(geo::Coordinates point, size_t count) const;
+
+	AreaInfo GetStopsInArea(const geo::Area& area) const;
+
+	std::vector<std::string> FindStopsByPrefix(std::string_view prefix, size_t count) const;
+
+	// Приблизительный объём памяти, занимаемой справочником и его индексами
+	size_t EstimateMemoryUsage() const;
+
 private:
 	std::deque<Stop> stops_;
-	std::unordered_map<std::string_view, const Stop*> stopname_to_stop_;
+	std::unordered_map<std::string_view, Stop*> stopname_to_stop_;
 	std::deque<Bus> buses_;
-	std::unordered_map<std::string_view, const Bus*> busname_to_bus_;
+	std::unordered_map<std::string_view, Bus*> busname_to_bus_;
 	std::unordered_map<const Stop*, std::set<std::string>> stopname_to_buses_;
 	DistancesContainer stops_to_distances_;
+	StopSpatialIndex spatial_index_;
+	StopNameIndex name_index_;
 };
 
 }
\ No newline at end of file
@@ -23,6 +23,23 @@ std::optional<RouteInfo> TransportRouteProcessor::GetRoute(std::string_view from
     return BuildRouteInfo(route.value());
 }
 
+size_t TransportRouteProcessor::EstimateMemoryUsage() const {
+    constexpr size_t hash_node_overhead = 2 * sizeof(void*);
+    // Router хранит для каждой пары вершин std::optional с весом и номером ребра
+    constexpr size_t route_data_size = sizeof(std::optional<std::pair<double, std::optional<EdgeId>>>);
+    const size_t vertex_count = graph_.GetVertexCount();
+    size_t result = sizeof(*this);
+    result += graph_.GetEdgeCount() * (sizeof(Edge) + sizeof(EdgeId));
+    result += vertex_count * (sizeof(std::vector<EdgeId>) + sizeof(std::vector<void*>));
+    result += vertex_count * vertex_count * route_data_size;
+    for (const auto& [edge_id, info] : edge_id_to_busroute_info_) {
+        result += sizeof(std::pair<EdgeId, BusRouteInfo>) + info.busname.capacity() + hash_node_overhead;
+    }
+    result += (wait_vertex_id_to_stop_.size() + stop_to_wait_vertex_id_.size() + stop_to_bus_vertex_id_.size())
+        * (sizeof(std::pair<std::string_view, VertexId>) + hash_node_overhead);
+    return result;
+}
+
 graph::DirectedWeightedGraph<double> TransportRouteProcessor::BuildGraph() {
     Graph result_graph(catalogue_.GetAllStops().size() * 2);
 
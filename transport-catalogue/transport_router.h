@@ -33,6 +33,9 @@ public:
 
     std::optional<RouteInfo> GetRoute(std::string_view from, std::string_view to) const;
 
+    // Приблизительный объём памяти графа и предрассчитанных маршрутов
+    size_t EstimateMemoryUsage() const;
+
 private:
     std::unordered_map<VertexId, std::string> wait_vertex_id_to_stop_;
     std::unordered_map<std::string_view, VertexId> stop_to_wait_vertex_id_;
@@ -0,0 +1,52 @@
+#include "versioned_catalogue.h"
+
+namespace transport_catalogue {
+
+CatalogueVersion::CatalogueVersion(uint64_t number, TransportCatalogue catalogue,
+        TransportRouteProcessor::RoutingSettings routing_settings,
+        const renderer::RenderSettings& render_settings)
+    : number(number), catalogue(std::move(catalogue)), router(routing_settings, this->catalogue),
+    renderer(render_settings, this->catalogue.GetStopCoordinates()) {
+}
+
+VersionedCatalogue::VersionedCatalogue(TransportCatalogue catalogue,
+        TransportRouteProcessor::RoutingSettings routing_settings, renderer::RenderSettings render_settings)
+    : routing_settings_(routing_settings), render_settings_(std::move(render_settings)),
+    versions_(std::make_unique<CatalogueVersion>(1, std::move(catalogue), routing_settings, render_settings_)) {
+}
+
+VersionedCatalogue::Snapshot VersionedCatalogue::Acquire() const {
+    return versions_.Acquire();
+}
+
+void VersionedCatalogue::ApplyUpdate(const Update& update) {
+    std::lock_guard guard(update_mutex_);
+    auto current = versions_.Acquire();
+    TransportCatalogue next = current->catalogue;
+    update(next);
+    next.BuildIndexes();
+    auto version = std::make_unique<CatalogueVersion>(current->number + 1, std::move(next),
+        routing_settings_, render_settings_);
+    // Настройки отрисовки те же, поэтому новая карта может взять неизменившиеся фрагменты
+    version->renderer.ReuseFragments(current->renderer);
+    versions_.Publish(std::move(version));
+}
+
+void VersionedCatalogue::Replace(TransportCatalogue catalogue,
+        TransportRouteProcessor::RoutingSettings routing_settings, renderer::RenderSettings render_settings) {
+    std::lock_guard guard(update_mutex_);
+    auto current = versions_.Acquire();
+    const bool same_render_settings = render_settings == render_settings_;
+    routing_settings_ = routing_settings;
+    render_settings_ = std::move(render_settings);
+    auto version = std::make_unique<CatalogueVersion>(current->number + 1, std::move(catalogue),
+        routing_settings_, render_settings_);
+    // Фрагменты сравниваются с новыми маршрутами и остановками по содержимому,
+    // поэтому их можно взять и у версии, построенной из других данных
+    if (same_render_settings) {
+        version->renderer.ReuseFragments(current->renderer);
+    }
+    versions_.Publish(std::move(version));
+}
+
+} // namespace transport_catalogue
\ No newline at end of file
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "map_renderer.h"
+#include "response_cache.h"
+#include "snapshot.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace transport_catalogue {
+
+struct CatalogueVersion {
+    CatalogueVersion(uint64_t number, TransportCatalogue catalogue,
+        TransportRouteProcessor::RoutingSettings routing_settings,
+        const renderer::RenderSettings& render_settings);
+
+    CatalogueVersion(const CatalogueVersion&) = delete;
+    CatalogueVersion& operator=(const CatalogueVersion&) = delete;
+
+    const uint64_t number;
+    const TransportCatalogue catalogue;
+    const TransportRouteProcessor router;
+    // Рендерер сохраняет карту, отрисованную при первом запросе
+    mutable renderer::MapRenderer renderer;
+    // Записанные ответы на запросы Bus и Stop к этой версии
+    mutable json_processing::ResponseCache responses;
+};
+
+class VersionedCatalogue {
+public:
+    using Snapshot = snapshot::EpochSnapshots<CatalogueVersion>::Pin;
+    using Update = std::function<void(TransportCatalogue&)>;
+
+    VersionedCatalogue(TransportCatalogue catalogue, TransportRouteProcessor::RoutingSettings routing_settings,
+        renderer::RenderSettings render_settings);
+
+    // Закрепляет текущую версию. Не блокируется, даже если параллельно строится следующая
+    Snapshot Acquire() const;
+
+    // Строит следующую версию из копии текущей и публикует её. Обновления выполняются по одному
+    void ApplyUpdate(const Update& update);
+
+    // Публикует версию, целиком построенную из новых данных и настроек. Если настройки
+    // отрисовки не изменились, карта новой версии берёт неизменившиеся фрагменты текущей
+    void Replace(TransportCatalogue catalogue, TransportRouteProcessor::RoutingSettings routing_settings,
+        renderer::RenderSettings render_settings);
+
+private:
+    TransportRouteProcessor::RoutingSettings routing_settings_;
+    renderer::RenderSettings render_settings_;
+    std::mutex update_mutex_;
+    snapshot::EpochSnapshots<CatalogueVersion> versions_;
+};
+
+} // namespace transport_catalogue
\ No newline at end of file